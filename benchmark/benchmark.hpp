@@ -0,0 +1,218 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <functional>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <new>
+#include <algorithm>
+#include <utility>
+#include <cstdio>
+#include <cstdlib>
+#include <cstddef>
+
+/***** benchmark settings *****/
+#ifndef BENCHMARK_MIN_TIME
+#define BENCHMARK_MIN_TIME 0.02             // minimum duration of a timed repetition (seconds)
+#endif
+
+#ifndef BENCHMARK_REPETITIONS
+#define BENCHMARK_REPETITIONS 5             // timed repetitions of a benchmark (the fastest one is reported)
+#endif
+
+#ifndef BENCHMARK_MAX_LISTENERS
+#define BENCHMARK_MAX_LISTENERS 100000      // listeners of the largest emission benchmark
+#endif
+
+/**************** heap accounting ****************/
+// the global allocation functions are replaced to count the heap bytes in use,
+// so this header must be included by a single translation unit (the benchmark's)
+struct HeapCounter
+{
+    static constexpr std::size_t Header = alignof(std::max_align_t);     // size of an allocation is stored in front of it
+
+    static std::atomic<std::size_t> &Bytes() { static std::atomic<std::size_t> bytes{ 0 }; return bytes; }
+};
+
+// gcc inlines the replaced functions and can't tell that the memory they free comes from malloc (spurious warnings)
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#pragma GCC diagnostic ignored "-Warray-bounds"
+#endif
+
+void *operator new(std::size_t size)
+{
+    void *block = std::malloc(size + HeapCounter::Header);
+
+    if (!block)
+        throw std::bad_alloc();
+
+    *static_cast<std::size_t*>(block) = size;
+    HeapCounter::Bytes().fetch_add(size, std::memory_order_relaxed);
+
+    return static_cast<char*>(block) + HeapCounter::Header;
+}
+
+void operator delete(void *ptr) noexcept
+{
+    if (!ptr)
+        return;
+
+    void *block = static_cast<char*>(ptr) - HeapCounter::Header;
+
+    HeapCounter::Bytes().fetch_sub(*static_cast<std::size_t*>(block), std::memory_order_relaxed);
+    std::free(block);
+}
+
+void *operator new[](std::size_t size) { return operator new(size); }
+void operator delete[](void *ptr) noexcept { operator delete(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { operator delete(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { operator delete(ptr); }
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+/**** keep the compiler from optimizing away a computed value ****/
+template <typename Type>
+inline void DoNotOptimize(Type const &value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    static void const volatile *sink;
+    sink = &value;
+#endif
+}
+
+/**************** benchmark ****************/
+// times operations and prints one JSON object per result on the standard output, e.g.
+// {"variant": "fast delegates 17", "subject": "Delegate", "benchmark": "call", "listeners": 1, "value": 1.25, "unit": "ns"}
+class Benchmark
+{
+public:
+    explicit Benchmark(char const *variant) : mVariant(variant) {}
+
+    // times body() (one operation per call) and reports the average time of an operation in the fastest repetition
+    template <typename Body>
+    void Time(char const *subject, char const *name, std::size_t listeners, Body &&body) const;
+
+    void Report(char const *subject, char const *name, std::size_t listeners, double value, char const *unit) const;
+
+    // heap bytes in use
+    static std::size_t HeapBytes() { return HeapCounter::Bytes().load(std::memory_order_relaxed); }
+
+    // listener counts of the emission benchmarks (1, 10, 100, ... up to BENCHMARK_MAX_LISTENERS)
+    static std::vector<std::size_t> ListenerCounts();
+private:
+    char const *mVariant;
+
+    template <typename Body>
+    static double Run(Body &body, std::size_t iterations);
+};
+
+template <typename Body>
+void Benchmark::Time(char const *subject, char const *name, std::size_t listeners, Body &&body) const
+{
+    // double the iterations until a repetition lasts long enough
+    std::size_t iterations = 1;
+    double seconds = Run(body, iterations);
+
+    while (seconds < BENCHMARK_MIN_TIME && iterations < (std::size_t(1) << 30))
+    {
+        iterations *= 2;
+        seconds = Run(body, iterations);
+    }
+
+    double best = seconds / iterations;
+
+    for (int i = 1; i < BENCHMARK_REPETITIONS; i++)
+        best = std::min(best, Run(body, iterations) / iterations);
+
+    Report(subject, name, listeners, best * 1e9, "ns");
+}
+
+inline void Benchmark::Report(char const *subject, char const *name, std::size_t listeners, double value, char const *unit) const
+{
+    std::printf("{\"variant\": \"%s\", \"subject\": \"%s\", \"benchmark\": \"%s\", \"listeners\": %zu, \"value\": %.3f, \"unit\": \"%s\"}\n",
+                mVariant, subject, name, listeners, value, unit);
+    std::fflush(stdout);
+}
+
+inline std::vector<std::size_t> Benchmark::ListenerCounts()
+{
+    std::vector<std::size_t> counts;
+
+    for (std::size_t count = 1; count <= BENCHMARK_MAX_LISTENERS; count *= 10)
+        counts.push_back(count);
+
+    return counts;
+}
+
+template <typename Body>
+double Benchmark::Run(Body &body, std::size_t iterations)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    for (std::size_t i = 0; i < iterations; i++)
+        body();
+
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**************** listener ****************/
+// object whose member function is bound by the benchmarks
+struct Listener
+{
+    int value = 0;
+
+    void OnEvent(int i) { value += i; }
+};
+
+/**************** std::function baseline ****************/
+// the same benchmarks run on std::function (a multicast std::function being a vector of std::function)
+inline void BenchmarkStdFunction(Benchmark const &benchmark)
+{
+    using Function = std::function<void(int)>;
+
+    benchmark.Report("std::function", "sizeof", 1, sizeof(Function), "bytes");
+
+    Listener listener;
+    Function function = [&listener](int i) { listener.OnEvent(i); };
+    int argument = 1;
+
+    benchmark.Time("std::function", "call", 1, [&]() { function(argument); });
+    DoNotOptimize(listener.value);
+
+    benchmark.Time("std::function", "copy", 1, [&]() { Function copy(function); DoNotOptimize(copy); });
+    benchmark.Time("std::function", "move", 1, [&]() { Function moved(std::move(function)); function = std::move(moved); DoNotOptimize(function); });
+
+    std::vector<std::size_t> counts = Benchmark::ListenerCounts();
+    std::vector<Listener> listeners(counts.back());
+
+    for (std::size_t count : counts)
+    {
+        std::vector<Function> functions;
+
+        std::size_t heap = Benchmark::HeapBytes();
+
+        for (std::size_t i = 0; i < count; i++)
+            functions.push_back([&target = listeners[i]](int i) { target.OnEvent(i); });
+
+        benchmark.Report("std::function", "heap_per_listener", count, double(Benchmark::HeapBytes() - heap) / count, "bytes");
+
+        benchmark.Time("std::function", "bind_unbind", count, [&]()
+        {
+            functions.push_back([&listener](int i) { listener.OnEvent(i); });
+            functions.pop_back();
+        });
+
+        benchmark.Time("std::function", "emit", count, [&]() { for (Function &function : functions) function(argument); });
+
+        benchmark.Time("std::function", "copy", count, [&]() { std::vector<Function> copy(functions); DoNotOptimize(copy); });
+    }
+}
+
+#endif  // BENCHMARK_H
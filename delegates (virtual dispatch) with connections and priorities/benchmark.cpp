@@ -0,0 +1,88 @@
+// microbenchmarks of the delegates and signals against std::function, printing one JSON object per result (see ../benchmark/benchmark.hpp)
+// built by the benchmarks target of the top level CMakeLists.txt, or by hand with optimizations, e.g. g++ -std=c++17 -O2 -DNDEBUG -pthread benchmark.cpp -o benchmark
+
+#include "signal.hpp"
+#include "../benchmark/benchmark.hpp"
+
+using SingleDelegate = Delegate<void(int)>;
+using EventSignal = Signal<void(int)>;
+
+// listeners of the signals are spread over this many priorities
+constexpr unsigned int Priorities = 8;
+
+// delegates are move only
+void BenchmarkDelegate(Benchmark const &benchmark)
+{
+    benchmark.Report("Delegate", "sizeof", 1, sizeof(SingleDelegate), "bytes");
+
+    Listener listener;
+    int argument = 1;
+
+    SingleDelegate member;
+    member.Bind(listener, &Listener::OnEvent);
+
+    benchmark.Time("Delegate/member", "call", 1, [&]() { member(argument); });
+
+    SingleDelegate lambda;
+    lambda.Bind([&listener](int i) { listener.OnEvent(i); });
+
+    benchmark.Time("Delegate/lambda", "call", 1, [&]() { lambda(argument); });
+    DoNotOptimize(listener.value);
+
+    benchmark.Time("Delegate/lambda", "move", 1, [&]() { SingleDelegate moved(std::move(lambda)); lambda = std::move(moved); DoNotOptimize(lambda); });
+}
+
+// listeners bound as member functions and as rvalue lambdas
+void BenchmarkSignal(Benchmark const &benchmark)
+{
+    benchmark.Report("Signal", "sizeof", 1, sizeof(EventSignal), "bytes");
+
+    std::vector<std::size_t> counts = Benchmark::ListenerCounts();
+    std::vector<Listener> listeners(counts.back());
+
+    Listener extra;
+    int argument = 1;
+
+    for (std::size_t count : counts)
+    {
+        {
+            std::size_t heap = Benchmark::HeapBytes();
+            EventSignal signal;
+
+            for (std::size_t i = 0; i < count; i++)
+                signal.Bind(listeners[i], &Listener::OnEvent, i % Priorities);
+
+            benchmark.Report("Signal/member", "heap_per_listener", count, double(Benchmark::HeapBytes() - heap) / count, "bytes");
+
+            benchmark.Time("Signal/member", "bind_unbind", count, [&]() { signal.Bind(extra, &Listener::OnEvent, Priorities / 2).Disconnect(); });
+            benchmark.Time("Signal/member", "emit", count, [&]() { signal(argument); });
+        }
+
+        {
+            std::size_t heap = Benchmark::HeapBytes();
+            EventSignal signal;
+
+            for (std::size_t i = 0; i < count; i++)
+                signal.Bind([&target = listeners[i]](int i) { target.OnEvent(i); }, i % Priorities);
+
+            benchmark.Report("Signal/lambda", "heap_per_listener", count, double(Benchmark::HeapBytes() - heap) / count, "bytes");
+
+            benchmark.Time("Signal/lambda", "bind_unbind", count, [&]() { signal.Bind([&extra](int i) { extra.OnEvent(i); }, Priorities / 2).Disconnect(); });
+            benchmark.Time("Signal/lambda", "emit", count, [&]() { signal(argument); });
+        }
+    }
+
+    DoNotOptimize(listeners);
+    DoNotOptimize(extra.value);
+}
+
+int main()
+{
+    Benchmark benchmark("delegates (virtual dispatch) with connections and priorities");
+
+    BenchmarkStdFunction(benchmark);
+    BenchmarkDelegate(benchmark);
+    BenchmarkSignal(benchmark);
+
+    return 0;
+}
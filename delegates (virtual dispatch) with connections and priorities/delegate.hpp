@@ -4,9 +4,16 @@
 #include <utility>  
 #include <type_traits>
 #include <exception>
+#include <new>
+#include <cstddef>
 #include "callable.hpp"
 #include "connection.hpp"
 
+/***** size of the storage of the callable wrappers constructed inside a delegate *****/
+#ifndef DELEGATE_INLINE_SIZE
+#define DELEGATE_INLINE_SIZE (4 * sizeof(void*))    // fits a member function wrapper
+#endif
+
 /***** delegate exceptions *****/
 class DelegateNotBoundException : public std::exception
 {
@@ -52,30 +59,23 @@ void swap(Delegate<Signature> &d1, Delegate<Signature> &d2)
     d1.Swap(d2);
 }
 
-template <typename Signature>
-bool operator<(Delegate<Signature> const &d1, Delegate<Signature> const &d2)
-{
-    return d1.mPriority < d2.mPriority;
-}
-
 /**** delegate partial class template specialization for function types ****/
-template <typename Ret, typename... Args>
-class Delegate<Ret(Args...)> 
+template <typename Ret, typename... Args, bool NoExcept>
+class Delegate<Ret(Args...) noexcept(NoExcept)> 
 {
-friend class Signal<Ret(Args...)>;
-friend bool operator< <Ret(Args...)>(Delegate const &, Delegate const &);
+friend class Signal<Ret(Args...) noexcept(NoExcept)>;
 public:
-    Delegate() : mCallableWrapper(nullptr) {}
+    Delegate() : mCallableWrapper(nullptr), mPriority(-1) {}
 
     Delegate(const Delegate &other) = delete;
 
-    Delegate(Delegate &&other);
+    Delegate(Delegate &&other) noexcept;
 
     ~Delegate();
 
     Delegate &operator=(Delegate const &other) = delete;
 
-    Delegate &operator=(Delegate &&other);
+    Delegate &operator=(Delegate &&other) noexcept;
 
     // template <typename T>
     // void Bind(T &instance, Ret (T::*ptrToMemFun)(Args...), unsigned int priority = -1);
@@ -100,32 +100,50 @@ public:
 
     explicit operator bool() const { return mCallableWrapper != nullptr; }
 
-    Ret operator()(Args... args) const;  
+    Ret operator()(Args... args) const noexcept(NoExcept);  
 
-    Ret Invoke(Args... args) const;
+    Ret Invoke(Args... args) const noexcept(NoExcept);
 private:
-    CallableWrapper<Ret(Args...)> *mCallableWrapper; 
+    using Storage = std::aligned_storage_t<DELEGATE_INLINE_SIZE, alignof(void*)>;
+
+    // wrappers that fit and can't throw when moved are constructed inside the delegate (no allocation, no pointer chasing)
+    template <typename WrapperType>
+    static constexpr bool StoredInline = sizeof(WrapperType) <= sizeof(Storage) && alignof(WrapperType) <= alignof(Storage) && std::is_nothrow_move_constructible_v<WrapperType>;
+
+    Storage mStorage;
+    CallableWrapper<Ret(Args...) noexcept(NoExcept)> *mCallableWrapper;     // points to mStorage if the wrapper is stored inline
     unsigned int mPriority;
+
+    bool Inline() const;
+
+    template <typename WrapperType, typename... WrapperArgs>
+    void Construct(WrapperArgs&&... wrapperArgs);
+
+    void MoveFrom(Delegate &other) noexcept;
+
+    void Reset() noexcept;
 };
 
-template <typename Ret, typename... Args>
-Delegate<Ret(Args...)>::Delegate(Delegate &&other) : mCallableWrapper(other.mCallableWrapper), mPriority(other.mPriority)
+template <typename Ret, typename... Args, bool NoExcept>
+Delegate<Ret(Args...) noexcept(NoExcept)>::Delegate(Delegate &&other) noexcept : mCallableWrapper(nullptr)
 {
-    other.mCallableWrapper = nullptr;
+    MoveFrom(other);
 }
 
-template <typename Ret, typename... Args>
-Delegate<Ret(Args...)>::~Delegate() 
+template <typename Ret, typename... Args, bool NoExcept>
+Delegate<Ret(Args...) noexcept(NoExcept)>::~Delegate() 
 {
-    delete mCallableWrapper; 
-    mCallableWrapper = nullptr;
+    Reset();
 }
 
-template <typename Ret, typename... Args>
-Delegate<Ret(Args...)> &Delegate<Ret(Args...)>::operator=(Delegate &&other)
+template <typename Ret, typename... Args, bool NoExcept>
+Delegate<Ret(Args...) noexcept(NoExcept)> &Delegate<Ret(Args...) noexcept(NoExcept)>::operator=(Delegate &&other) noexcept
 {
-    Delegate temp(std::move(other));
-    Swap(temp);
+    if (this != &other)
+    {
+        Reset();
+        MoveFrom(other);
+    }
 
     return *this;
 }
@@ -152,56 +170,115 @@ Delegate<Ret(Args...)> &Delegate<Ret(Args...)>::operator=(Delegate &&other)
 //     mPriority = priority;
 // }
 
-template <typename Ret, typename... Args>
+template <typename Ret, typename... Args, bool NoExcept>
 template <typename T, typename PtrToMemFun>
-std::enable_if_t<std::is_member_function_pointer_v<PtrToMemFun>> Delegate<Ret(Args...)>::Bind(T &instance, PtrToMemFun ptrToMemFun, unsigned int priority)
+std::enable_if_t<std::is_member_function_pointer_v<PtrToMemFun>> Delegate<Ret(Args...) noexcept(NoExcept)>::Bind(T &instance, PtrToMemFun ptrToMemFun, unsigned int priority)
 {
+    static_assert(!NoExcept || std::is_nothrow_invocable_r_v<Ret, PtrToMemFun, T&, Args...>, "a noexcept delegate can only be bound to a noexcept callable");
+
     if (mCallableWrapper)
         throw DelegateAlreadyBoundException();
 
-    mCallableWrapper = new MemFunCallableWrapper<Ret(Args...), T, PtrToMemFun>(instance, ptrToMemFun);
+    Construct<MemFunCallableWrapper<Ret(Args...) noexcept(NoExcept), T, PtrToMemFun>>(instance, ptrToMemFun);
     mPriority = priority;
 }
 
-template <typename Ret, typename... Args>
+template <typename Ret, typename... Args, bool NoExcept>
 template <typename T>
-void Delegate<Ret(Args...)>::Bind(T &&funObj, unsigned int priority)
+void Delegate<Ret(Args...) noexcept(NoExcept)>::Bind(T &&funObj, unsigned int priority)
 {
+    static_assert(!NoExcept || std::is_nothrow_invocable_r_v<Ret, T, Args...>, "a noexcept delegate can only be bound to a noexcept callable");
+
     if (mCallableWrapper)
         throw DelegateAlreadyBoundException();
 
-    mCallableWrapper = new FunObjCallableWrapper<Ret(Args...), std::remove_reference_t<T>>(std::forward<T>(funObj));  
+    Construct<FunObjCallableWrapper<Ret(Args...) noexcept(NoExcept), T>>(std::forward<T>(funObj));
     mPriority = priority;
 }
 
-template <typename Ret, typename... Args>
-void Delegate<Ret(Args...)>::Swap(Delegate &other)
+template <typename Ret, typename... Args, bool NoExcept>
+void Delegate<Ret(Args...) noexcept(NoExcept)>::Swap(Delegate &other)
 {
-    CallableWrapper<Ret(Args...)> *callableTemp = mCallableWrapper;
-    mCallableWrapper = other.mCallableWrapper;
-    other.mCallableWrapper = callableTemp;
-
-    unsigned int priorityTemp = mPriority;
-    mPriority = other.mPriority;
-    other.mPriority = priorityTemp;
+    // inline wrappers can't be swapped by pointer, they're moved
+    Delegate temp(std::move(other));
+    other.MoveFrom(*this);
+    MoveFrom(temp);
 }
 
-template <typename Ret, typename... Args>
-Ret Delegate<Ret(Args...)>::operator()(Args... args) const
+template <typename Ret, typename... Args, bool NoExcept>
+Ret Delegate<Ret(Args...) noexcept(NoExcept)>::operator()(Args... args) const noexcept(NoExcept)
 {
     if (!mCallableWrapper)
-        throw DelegateNotBoundException();
+    {
+        if constexpr (NoExcept)
+            std::terminate();   // a noexcept delegate can't throw
+        else
+            throw DelegateNotBoundException();
+    }
 
     return mCallableWrapper->Invoke(std::forward<Args>(args)...);
 }
 
-template <typename Ret, typename... Args>
-Ret Delegate<Ret(Args...)>::Invoke(Args... args) const
+template <typename Ret, typename... Args, bool NoExcept>
+Ret Delegate<Ret(Args...) noexcept(NoExcept)>::Invoke(Args... args) const noexcept(NoExcept)
 {
     if (!mCallableWrapper)
-        throw DelegateNotBoundException();
+    {
+        if constexpr (NoExcept)
+            std::terminate();   // a noexcept delegate can't throw
+        else
+            throw DelegateNotBoundException();
+    }
 
     return mCallableWrapper->Invoke(std::forward<Args>(args)...);
 }
 
+template <typename Ret, typename... Args, bool NoExcept>
+bool Delegate<Ret(Args...) noexcept(NoExcept)>::Inline() const
+{
+    char const *wrapper = reinterpret_cast<char const*>(mCallableWrapper);
+    char const *storage = reinterpret_cast<char const*>(&mStorage);
+
+    return wrapper >= storage && wrapper < storage + sizeof(Storage);
+}
+
+template <typename Ret, typename... Args, bool NoExcept>
+template <typename WrapperType, typename... WrapperArgs>
+void Delegate<Ret(Args...) noexcept(NoExcept)>::Construct(WrapperArgs&&... wrapperArgs)
+{
+    if constexpr (StoredInline<WrapperType>)
+        mCallableWrapper = ::new(static_cast<void*>(&mStorage)) WrapperType(std::forward<WrapperArgs>(wrapperArgs)...);
+    else
+        mCallableWrapper = new WrapperType(std::forward<WrapperArgs>(wrapperArgs)...);
+}
+
+// this delegate must be unbound, other is left unbound
+template <typename Ret, typename... Args, bool NoExcept>
+void Delegate<Ret(Args...) noexcept(NoExcept)>::MoveFrom(Delegate &other) noexcept
+{
+    mPriority = other.mPriority;
+
+    if (other.Inline())
+    {
+        mCallableWrapper = other.mCallableWrapper->MoveTo(&mStorage);
+        other.Reset();
+    }
+    else
+    {
+        mCallableWrapper = other.mCallableWrapper;
+        other.mCallableWrapper = nullptr;
+    }
+}
+
+template <typename Ret, typename... Args, bool NoExcept>
+void Delegate<Ret(Args...) noexcept(NoExcept)>::Reset() noexcept
+{
+    if (Inline())
+        mCallableWrapper->~CallableWrapper();
+    else
+        delete mCallableWrapper;
+
+    mCallableWrapper = nullptr;
+}
+
 #endif  // DELEGATE_H
\ No newline at end of file
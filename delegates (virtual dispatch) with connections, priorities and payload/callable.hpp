@@ -1,19 +1,34 @@
 #ifndef CALLABLE_WRAPPER_H
 #define CALLABLE_WRAPPER_H
 
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include "callable_pool.hpp"
 #include "../../tuple/tuple.hpp"
 
 /***** base callable wrapper class *****/
 template <typename Signature>
 class CallableWrapper;
 
-template <typename Ret, typename... Args>
-class CallableWrapper<Ret(Args...)>
+template <typename Ret, typename... Args, bool NoExcept>
+class CallableWrapper<Ret(Args...) noexcept(NoExcept)>
 {
 public:
     virtual ~CallableWrapper() = default;
 
-    virtual Ret Invoke(Args... args) = 0;
+    virtual Ret Invoke(Args... args) noexcept(NoExcept) = 0;
+
+    // move constructs the wrapper in storage (wrappers stored inside a delegate are moved with it)
+    virtual CallableWrapper *MoveTo(void *storage) noexcept = 0;
+
+    // wrappers are allocated from the callable pool (the sized delete gets the size of the most derived wrapper)
+    static void *operator new(std::size_t size) { return CallablePool::Allocate(size); }
+    static void operator delete(void *ptr, std::size_t size) noexcept { CallablePool::Deallocate(ptr, size); }
+
+    // over-aligned wrappers (function objects with over-aligned captures) bypass the pool, whose blocks are only aligned to max_align_t
+    static void *operator new(std::size_t size, std::align_val_t alignment) { return ::operator new(size, alignment); }
+    static void operator delete(void *ptr, std::size_t size, std::align_val_t alignment) noexcept { ::operator delete(ptr, size, alignment); }
 protected:
     CallableWrapper() = default;
 };
@@ -88,69 +103,64 @@ protected:
 template <typename Signature, typename T, typename PtrToMemFun, typename... Payload>
 class MemFunCallableWrapper;
 
-template <typename Ret, typename... Args, typename T, typename PtrToMemFun, typename... Payload>
-class MemFunCallableWrapper<Ret(Args...), T, PtrToMemFun, Payload...> : public CallableWrapper<Ret(Args...)>
+template <typename Ret, typename... Args, bool NoExcept, typename T, typename PtrToMemFun, typename... Payload>
+class MemFunCallableWrapper<Ret(Args...) noexcept(NoExcept), T, PtrToMemFun, Payload...> : public CallableWrapper<Ret(Args...) noexcept(NoExcept)>
 {
 public:
     MemFunCallableWrapper(T &instance, PtrToMemFun ptrToMemFun, Payload... payload) : mInstance(instance), mPtrToMemFun(ptrToMemFun), mPayload(payload...) {}
 
-    Ret Invoke(Args... args) override 
+    // the payload replaces the leading arguments, the remaining arguments are forwarded by reference (nothing is stored)
+    Ret Invoke(Args... args) noexcept(NoExcept) override 
     {  
-        mArguments = Tuple<Args...>(args...); 
-        return InvokeImpl(mPayloadSequence, mArgsSequence); 
+        return InvokeImpl(MakeIndexSequence<sizeof...(Payload)>(), MakeIndexSequenceFrom<sizeof...(Payload), sizeof...(Args)>(), std::forward_as_tuple(std::forward<Args>(args)...)); 
     }
+
+    CallableWrapper<Ret(Args...) noexcept(NoExcept)> *MoveTo(void *storage) noexcept override { return ::new(storage) MemFunCallableWrapper(std::move(*this)); }
 private:
     T &mInstance;
     PtrToMemFun mPtrToMemFun;
 
     Tuple<Payload...> mPayload;
-    MakeIndexSequence<sizeof...(Payload)> mPayloadSequence;
-    Tuple<Args...> mArguments;
-    MakeIndexSequenceFrom<sizeof...(Payload), sizeof...(Args)> mArgsSequence;
 
     template <std::size_t... PayloadSequence, std::size_t... ArgsSequence>
-    Ret InvokeImpl(IndexSequence<PayloadSequence...>, IndexSequence<ArgsSequence...>)
+    Ret InvokeImpl(IndexSequence<PayloadSequence...>, IndexSequence<ArgsSequence...>, std::tuple<Args&&...> arguments) noexcept(NoExcept)
     {
-        return (mInstance.*mPtrToMemFun)(std::forward<decltype(Get<PayloadSequence>(mPayload))>(Get<PayloadSequence>(mPayload))..., std::forward<decltype(Get<ArgsSequence>(mArguments))>(Get<ArgsSequence>(mArguments))...);
+        static_assert(!NoExcept || std::is_nothrow_invocable_r_v<Ret, PtrToMemFun, T&, decltype(Get<PayloadSequence>(mPayload))..., decltype(std::get<ArgsSequence>(std::move(arguments)))...>, "a noexcept delegate can only be bound to a noexcept callable");
+
+        return (mInstance.*mPtrToMemFun)(std::forward<decltype(Get<PayloadSequence>(mPayload))>(Get<PayloadSequence>(mPayload))..., std::get<ArgsSequence>(std::move(arguments))...);
     }
 };
 
 /***** wrapper around a function object/lambda *****/
+// T is an lvalue reference type for function objects bound as lvalues (the wrapper refers to them), otherwise the function 
+// object is moved into the wrapper (one allocation per bind at most, the function object is called without an indirection)
 template <typename Signature, typename T, typename... Payload>
 class FunObjCallableWrapper;
 
-template <typename Ret, typename... Args, typename T, typename... Payload>
-class FunObjCallableWrapper<Ret(Args...), T, Payload...> : public CallableWrapper<Ret(Args...)>
+template <typename Ret, typename... Args, bool NoExcept, typename T, typename... Payload>
+class FunObjCallableWrapper<Ret(Args...) noexcept(NoExcept), T, Payload...> : public CallableWrapper<Ret(Args...) noexcept(NoExcept)>
 {
 public:
-    FunObjCallableWrapper(T &funObject, Payload... payload) : mFunObject(&funObject), mPayload(payload...), mAllocated(false) {}
-    FunObjCallableWrapper(T &&funObject, Payload... payload) : mFunObject(new T(std::move(funObject))), mPayload(payload...), mAllocated(true) {} 
+    FunObjCallableWrapper(T &&funObject, Payload... payload) : mFunObject(std::forward<T>(funObject)), mPayload(payload...) {}
 
-    ~FunObjCallableWrapper() { Destroy(); }
-
-    Ret Invoke(Args... args) override 
+    // the payload replaces the leading arguments, the remaining arguments are forwarded by reference (nothing is stored)
+    Ret Invoke(Args... args) noexcept(NoExcept) override 
     {  
-        mArguments = Tuple<Args...>(args...); 
-        return InvokeImpl(mPayloadSequence, mArgsSequence); 
+        return InvokeImpl(MakeIndexSequence<sizeof...(Payload)>(), MakeIndexSequenceFrom<sizeof...(Payload), sizeof...(Args)>(), std::forward_as_tuple(std::forward<Args>(args)...)); 
     }
-private:
-    template <typename U = T, typename = std::enable_if_t<std::is_function<U>::value>>                  // dummy type param defaulted to T (SFINAE)
-    void Destroy() {}
-    template <typename U = T, typename = std::enable_if_t<!std::is_function<U>::value>, typename = T>   // dummy type param defaulted to T (SFINAE) + extra type param (for overloading)
-    void Destroy() { if (mAllocated) delete mFunObject; }                                               // SFINAE-out if T has function type
 
-    T *mFunObject;
-    bool mAllocated;
+    CallableWrapper<Ret(Args...) noexcept(NoExcept)> *MoveTo(void *storage) noexcept override { return ::new(storage) FunObjCallableWrapper(std::move(*this)); }
+private:
+    std::conditional_t<std::is_lvalue_reference<T>::value, std::reference_wrapper<std::remove_reference_t<T>>, T> mFunObject;
 
     Tuple<Payload...> mPayload;
-    MakeIndexSequence<sizeof...(Payload)> mPayloadSequence;
-    Tuple<Args...> mArguments;
-    MakeIndexSequenceFrom<sizeof...(Payload), sizeof...(Args)> mArgsSequence;
 
     template <std::size_t... PayloadSequence, std::size_t... ArgsSequence>
-    Ret InvokeImpl(IndexSequence<PayloadSequence...>, IndexSequence<ArgsSequence...>)
+    Ret InvokeImpl(IndexSequence<PayloadSequence...>, IndexSequence<ArgsSequence...>, std::tuple<Args&&...> arguments) noexcept(NoExcept)
     {
-        return (*mFunObject)(std::forward<decltype(Get<PayloadSequence>(mPayload))>(Get<PayloadSequence>(mPayload))..., std::forward<decltype(Get<ArgsSequence>(mArguments))>(Get<ArgsSequence>(mArguments))...);
+        static_assert(!NoExcept || std::is_nothrow_invocable_r_v<Ret, std::remove_reference_t<T>&, decltype(Get<PayloadSequence>(mPayload))..., decltype(std::get<ArgsSequence>(std::move(arguments)))...>, "a noexcept delegate can only be bound to a noexcept callable");
+
+        return mFunObject(std::forward<decltype(Get<PayloadSequence>(mPayload))>(Get<PayloadSequence>(mPayload))..., std::get<ArgsSequence>(std::move(arguments))...);
     }
 };
 
@@ -0,0 +1,213 @@
+#ifndef CALLABLE_POOL_H
+#define CALLABLE_POOL_H
+
+#include <vector>
+#include <mutex>
+#include <new>
+#include <cstddef>
+
+/***** callable pool settings *****/
+#ifndef CALLABLE_POOL_MAX_SIZE
+#define CALLABLE_POOL_MAX_SIZE 256          // larger callable wrappers are allocated by the global operator new
+#endif
+
+#ifndef CALLABLE_POOL_SLAB_BLOCKS
+#define CALLABLE_POOL_SLAB_BLOCKS 64        // blocks carved at a time from a new slab
+#endif
+
+#ifndef CALLABLE_POOL_CACHE_BLOCKS
+#define CALLABLE_POOL_CACHE_BLOCKS 256      // free blocks a thread keeps per size class (the surplus goes back to the shared free lists)
+#endif
+
+/**************** callable pool ****************/
+// size class allocator of the callable wrappers: every thread keeps a free list per size class and pops/pushes blocks
+// without locking; an empty free list is refilled from the blocks left by exited threads or from a new slab, so the
+// wrappers bound one after another sit next to each other in memory; a block can be freed by any thread (it goes to
+// that thread's free list, half of which is handed back to the shared free lists when it grows past the cache limit),
+// slabs are never released (they're reused through the free lists)
+class CallablePool
+{
+public:
+    static void *Allocate(std::size_t size);
+    static void Deallocate(void *block, std::size_t size) noexcept;
+private:
+    static constexpr std::size_t Granularity = alignof(std::max_align_t);
+    static constexpr std::size_t SizeClasses = (CALLABLE_POOL_MAX_SIZE + Granularity - 1) / Granularity;
+
+    static_assert(CALLABLE_POOL_CACHE_BLOCKS >= 2, "threads must cache at least two blocks per size class");
+
+    struct Block
+    {
+        Block *next;
+    };
+
+    // shared by all the threads, never destroyed (blocks can be freed during static destruction)
+    struct Shared
+    {
+        std::mutex mutex;
+        Block *free[SizeClasses] = {};      // free lists of the exited threads
+        std::vector<void*> slabs;           // keeps the slabs reachable
+    };
+
+    // free lists of a thread, handed over to the shared free lists when the thread exits
+    struct Cache
+    {
+        Block *free[SizeClasses] = {};
+        std::size_t count[SizeClasses] = {};    // blocks in each free list
+
+        ~Cache();
+    };
+
+    static Shared &GetShared() { static Shared *shared = new Shared; return *shared; }
+    static Cache &GetCache() { static thread_local Cache cache; return cache; }
+    static bool &Exited() { static thread_local bool exited = false; return exited; }     // set once the cache is destroyed
+
+    static std::size_t SizeClass(std::size_t size) { return (size - 1) / Granularity; }
+
+    static Block *Refill(std::size_t sizeClass, std::size_t &count);
+    static void Release(std::size_t sizeClass, Block *blocks);
+    static void Trim(Cache &cache, std::size_t sizeClass);
+};
+
+inline void *CallablePool::Allocate(std::size_t size)
+{
+    if (size == 0 || size > CALLABLE_POOL_MAX_SIZE)
+        return ::operator new(size);
+
+    std::size_t sizeClass = SizeClass(size);
+
+    // a thread whose cache is gone (wrappers bound by thread_local/static destructors) uses the shared free lists
+    if (Exited())
+    {
+        std::size_t count;
+        Block *block = Refill(sizeClass, count);
+        Release(sizeClass, block->next);
+
+        return block;
+    }
+
+    Cache &cache = GetCache();
+
+    if (!cache.free[sizeClass])
+        cache.free[sizeClass] = Refill(sizeClass, cache.count[sizeClass]);
+
+    Block *block = cache.free[sizeClass];
+    cache.free[sizeClass] = block->next;
+    cache.count[sizeClass]--;
+
+    return block;
+}
+
+inline void CallablePool::Deallocate(void *block, std::size_t size) noexcept
+{
+    if (!block)
+        return;
+
+    if (size == 0 || size > CALLABLE_POOL_MAX_SIZE)
+    {
+        ::operator delete(block);
+
+        return;
+    }
+
+    std::size_t sizeClass = SizeClass(size);
+    static_cast<Block*>(block)->next = nullptr;
+
+    if (Exited())
+    {
+        Release(sizeClass, static_cast<Block*>(block));
+
+        return;
+    }
+
+    Cache &cache = GetCache();
+
+    static_cast<Block*>(block)->next = cache.free[sizeClass];
+    cache.free[sizeClass] = static_cast<Block*>(block);
+
+    if (++cache.count[sizeClass] > CALLABLE_POOL_CACHE_BLOCKS)
+        Trim(cache, sizeClass);
+}
+
+// takes up to a slab's worth of blocks from the shared free list of the size class if there are any, otherwise carves a
+// new slab into a free list
+inline CallablePool::Block *CallablePool::Refill(std::size_t sizeClass, std::size_t &count)
+{
+    Shared &shared = GetShared();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+
+    if (Block *blocks = shared.free[sizeClass])
+    {
+        Block *last = blocks;
+
+        for (count = 1; last->next && count < CALLABLE_POOL_SLAB_BLOCKS; count++)
+            last = last->next;
+
+        shared.free[sizeClass] = last->next;
+        last->next = nullptr;
+
+        return blocks;
+    }
+
+    std::size_t blockSize = (sizeClass + 1) * Granularity;
+
+    shared.slabs.reserve(shared.slabs.size() + 1);     // so the slab isn't leaked if this throws
+    char *slab = static_cast<char*>(::operator new(blockSize * CALLABLE_POOL_SLAB_BLOCKS));
+    shared.slabs.push_back(slab);
+
+    Block *blocks = nullptr;
+
+    for (std::size_t i = CALLABLE_POOL_SLAB_BLOCKS; i-- != 0; )
+    {
+        Block *block = reinterpret_cast<Block*>(slab + i * blockSize);
+        block->next = blocks;
+        blocks = block;
+    }
+
+    count = CALLABLE_POOL_SLAB_BLOCKS;
+
+    return blocks;
+}
+
+// prepends a list of blocks to the shared free list of the size class
+inline void CallablePool::Release(std::size_t sizeClass, Block *blocks)
+{
+    if (!blocks)
+        return;
+
+    Block *last = blocks;
+
+    while (last->next)
+        last = last->next;
+
+    Shared &shared = GetShared();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+
+    last->next = shared.free[sizeClass];
+    shared.free[sizeClass] = blocks;
+}
+
+// keeps half of the cache limit in the thread's free list of the size class and hands the rest to the shared free list
+// (a thread freeing the wrappers allocated by other threads doesn't hoard them)
+inline void CallablePool::Trim(Cache &cache, std::size_t sizeClass)
+{
+    Block *last = cache.free[sizeClass];
+
+    for (std::size_t i = 1; i < CALLABLE_POOL_CACHE_BLOCKS / 2; i++)
+        last = last->next;
+
+    Release(sizeClass, last->next);
+    last->next = nullptr;
+
+    cache.count[sizeClass] = CALLABLE_POOL_CACHE_BLOCKS / 2;
+}
+
+inline CallablePool::Cache::~Cache()
+{
+    Exited() = true;
+
+    for (std::size_t i = 0; i < SizeClasses; i++)
+        Release(i, free[i]);
+}
+
+#endif  // CALLABLE_POOL_H
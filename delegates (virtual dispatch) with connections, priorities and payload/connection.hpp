@@ -1,34 +1,65 @@
 #ifndef CONNECTION_H
 #define CONNECTION_H
 
-template <typename Signature>
-class Signal;
+#include <cstdint>
 
 template <typename Signature>
-class CallableWrapper;
+class Signal;
 
+// handle to a delegate bound to a signal: the signal's slot tracking the delegate plus the slot's generation when the delegate 
+// was bound (a slot's generation changes every time its delegate is disconnected, so stale handles are ignored)
 class Connection
 {
 public:
-    Connection() : mSignal(nullptr), mCallableWrapper(nullptr), mDisconnectFunction(nullptr) {}
+    Connection() : mSignal(nullptr), mSlot(0), mGeneration(0), mOperations(nullptr) {}
     
-    template <typename Ret, typename... Args>
-    Connection(Signal<Ret(Args...)> *signal, CallableWrapper<Ret(Args...)> *callableWrapper) : mSignal(signal), mCallableWrapper(callableWrapper), mDisconnectFunction(&DisconnectFunction<Ret, Args...>) {}
+    template <typename Signature>
+    Connection(Signal<Signature> *signal, std::uint32_t slot, std::uint32_t generation) : mSignal(signal), mSlot(slot), mGeneration(generation), mOperations(Operations<Signature>()) {}
     
     void Disconnect() 
     { 
-        if (mDisconnectFunction)
-            mDisconnectFunction(mSignal, mCallableWrapper); 
+        if (mOperations)
+            mOperations->disconnect(mSignal, mSlot, mGeneration); 
+    }
+
+    // moves the delegate after the signal's delegates with the same priority
+    void SetPriority(unsigned int priority)
+    {
+        if (mOperations)
+            mOperations->setPriority(mSignal, mSlot, mGeneration, priority);
     }
 private:
-    void (*mDisconnectFunction)(void*, void*);
+    // functions of the signal type reachable through a connection (one static table per signal type)
+    struct SignalOperations
+    {
+        void (*disconnect)(void*, std::uint32_t, std::uint32_t);
+        void (*setPriority)(void*, std::uint32_t, std::uint32_t, unsigned int);
+    };
+
     void *mSignal;
-    void *mCallableWrapper;
+    std::uint32_t mSlot;
+    std::uint32_t mGeneration;
+    SignalOperations const *mOperations;
     
-    template <typename Ret, typename... Args>
-    static void DisconnectFunction(void *signal, void *callableWrapper)
+    template <typename Signature>
+    static SignalOperations const *Operations()
+    {
+        static const SignalOperations operations{ &DisconnectFunction<Signature>, &SetPriorityFunction<Signature> };
+
+        return &operations;
+    }
+
+
+    template <typename Signature>
+    static void DisconnectFunction(void *signal, std::uint32_t slot, std::uint32_t generation)
+    {
+        static_cast<Signal<Signature>*>(signal)->Disconnect(slot, generation);
+    }
+
+    template <typename Signature>
+    static void SetPriorityFunction(void *signal, std::uint32_t slot, std::uint32_t generation, unsigned int priority)
     {
-        static_cast<Signal<Ret(Args...)>*>(signal)->Unbind(static_cast<CallableWrapper<Ret(Args...)>*>(callableWrapper));
+        static_cast<Signal<Signature>*>(signal)->SetPriority(slot, generation, priority);
     }
 };
 
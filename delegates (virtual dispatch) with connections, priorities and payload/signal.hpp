@@ -2,9 +2,11 @@
 #define SIGNAL_H
 
 #include "delegate.hpp"
-#define TYPE_PARAM_HEAP_QUEUE
-#include "../../data structures/ADT/priority queue/priority_queue.hpp"
 #include <type_traits>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include "thread_pool.hpp"
 
 /***** signal typedefs *****/
 #define SIGNAL(SignalType)                                  typedef Signal<void()> SignalType
@@ -15,13 +17,19 @@
 #define SIGNAL_RET_ONE_PARAM(SignalType, ret, par0)         typedef Signal<ret(par0)> SignalType
 #define SIGNAL_RET_TWO_PARAM(SignalType, ret, par0, par1)   typedef Signal<ret(par0, par1)> SignalType
 
+/**** argument passed on to several delegates ****/
+// reference parameters are forwarded, parameters taken by value are passed as lvalues (so the delegates called later 
+// don't get moved-from values)
+template <typename Arg>
+using Relayed = std::conditional_t<std::is_reference_v<Arg>, Arg&&, Arg&>;
+
 /**** signal primary class template (not defined) ****/
 template <typename Signature>
 class Signal;
 
 /**** signal partial class template specialization for function types ****/
-template <typename Ret, typename... Args>
-class Signal<Ret(Args...)>  
+template <typename Ret, typename... Args, bool NoExcept>
+class Signal<Ret(Args...) noexcept(NoExcept)>  
 {
     friend class Connection;
 public:
@@ -44,12 +52,22 @@ public:
     template <typename T, typename... Payload>
     Connection Bind(T &&funObj, unsigned int priority, Payload&&... payload);
 
-    explicit operator bool() const { return !mDelegates.empty(); }
+    explicit operator bool() const { return mDelegates.size() != mTombstones || !mPendingDelegates.empty(); }
 
+    // delegates are called in priority order (highest first), delegates with the same priority in the order they were bound;
+    // binding and disconnecting are allowed while emitting (from inside the delegates): disconnected delegates are skipped
+    // and destroyed after the outermost emission, delegates bound while emitting are called from the next emission
     void operator()(Args... args); 
     
     void Invoke(Args... args);
 
+    // calls the delegates of each priority on the thread pool's threads (in no particular order within a priority), 
+    // starting the next priority only when all the delegates of the current one have returned;
+    // the delegates of a priority must be safe to call concurrently and mustn't bind to, disconnect from or reprioritize 
+    // delegates of the signal
+    void InvokeParallel(Args... args) { InvokeParallel(ThreadPool::Instance(), std::forward<Args>(args)...); }
+    void InvokeParallel(ThreadPool &pool, Args... args);
+
     template <typename F>
     void operator()(F const &f, Args... args);
 
@@ -58,9 +76,49 @@ public:
 
     void Clear();
 private:
-    void Unbind(CallableWrapper<Ret(Args...)> *callableWrapper);
+    // slot map: connections refer to slots that track their delegate's position in the sorted array of delegates
+    struct Slot
+    {
+        std::uint32_t index;        // position in mDelegates (next free slot if the slot is free)
+        std::uint32_t generation;   
+    };
 
-    PriorityQueue<Delegate<Ret(Args...)>> mDelegates;
+    // new priority of a delegate reprioritized while emitting
+    struct Reprioritization
+    {
+        std::uint32_t slot;
+        std::uint32_t generation;
+        unsigned int priority;
+    };
+
+    static constexpr std::uint32_t NoSlot = std::uint32_t(-1);
+    static constexpr std::uint32_t Pending = std::uint32_t(1) << 31;     // set in the index of the slots of pending delegates
+
+    std::vector<Delegate<Ret(Args...) noexcept(NoExcept)>> mDelegates;      // sorted by priority (stable, so equal priorities keep their binding order)
+    std::vector<std::uint32_t> mDelegateSlots;                          // slot of each delegate in mDelegates (NoSlot if disconnected)
+    std::vector<Slot> mSlots;
+    std::uint32_t mFreeSlot = NoSlot;                                   // head of the free slot list
+    std::size_t mTombstones = 0;                                        // disconnected delegates still in mDelegates
+
+    // state of the emission in progress
+    std::uint32_t mEmitting = 0;                                                    // depth of nested emissions
+    std::vector<Delegate<Ret(Args...) noexcept(NoExcept)>> mPendingDelegates;      // delegates bound while emitting
+    std::vector<std::uint32_t> mPendingSlots;
+    std::vector<Reprioritization> mReprioritized;                                   // delegates reprioritized while emitting
+    std::vector<std::uint32_t> mDeadDelegates;                                      // positions of the delegates disconnected while emitting
+
+    Connection Insert(Delegate<Ret(Args...) noexcept(NoExcept)> &&delegate);
+    void Place(Delegate<Ret(Args...) noexcept(NoExcept)> &&delegate, std::uint32_t slot);
+    bool Connected(std::uint32_t slot, std::uint32_t generation) const;
+    void Disconnect(std::uint32_t slot, std::uint32_t generation);
+    void SetPriority(std::uint32_t slot, std::uint32_t generation, unsigned int priority);
+    void Reposition(std::size_t index, unsigned int priority);
+    std::size_t UpperBound(std::size_t first, std::size_t last, unsigned int priority) const;
+    void UpdateSlots(std::size_t first, std::size_t last);
+    void FreeSlot(std::uint32_t slot);
+    void Tombstone(std::size_t index);
+    void EndEmission();
+    void Compact();
 };
 
 // template <typename Ret, typename... Args>
@@ -87,120 +145,379 @@ private:
 //     return Connection(this, callable); 
 // }
 
-template <typename Ret, typename... Args>
+template <typename Ret, typename... Args, bool NoExcept>
 template <typename T, typename PtrToMemFun, typename... Payload>
-std::enable_if_t<std::is_member_function_pointer_v<PtrToMemFun>, Connection> Signal<Ret(Args...)>::Bind(T &instance, PtrToMemFun ptrToMemFun, unsigned int priority, Payload&&... payload)
+std::enable_if_t<std::is_member_function_pointer_v<PtrToMemFun>, Connection> Signal<Ret(Args...) noexcept(NoExcept)>::Bind(T &instance, PtrToMemFun ptrToMemFun, unsigned int priority, Payload&&... payload)
 {
-    Delegate<Ret(Args...)> delegate;
+    Delegate<Ret(Args...) noexcept(NoExcept)> delegate;
     delegate.Bind(instance, ptrToMemFun, priority, std::forward<Payload>(payload)...);
-    CallableWrapper<Ret(Args...)> *callable = delegate.mCallableWrapper;
-    mDelegates.Insert(std::move(delegate));
 
-    return Connection(this, callable); 
+    return Insert(std::move(delegate)); 
 }
     
-template <typename Ret, typename... Args>
+template <typename Ret, typename... Args, bool NoExcept>
 template <typename T, typename... Payload>
-Connection Signal<Ret(Args...)>::Bind(T &&funObj, unsigned int priority, Payload&&... payload)
+Connection Signal<Ret(Args...) noexcept(NoExcept)>::Bind(T &&funObj, unsigned int priority, Payload&&... payload)
 {
-    Delegate<Ret(Args...)> delegate;
+    Delegate<Ret(Args...) noexcept(NoExcept)> delegate;
     delegate.Bind(std::forward<T>(funObj), priority, std::forward<Payload>(payload)...);
-    CallableWrapper<Ret(Args...)> *callable = delegate.mCallableWrapper;
-    mDelegates.Insert(std::move(delegate));
 
-    return Connection(this, callable);  
+    return Insert(std::move(delegate));  
 }
 
-template <typename Ret, typename... Args>
-void Signal<Ret(Args...)>::Unbind(CallableWrapper<Ret(Args...)> *callableWrapper)
+template <typename Ret, typename... Args, bool NoExcept>
+bool Signal<Ret(Args...) noexcept(NoExcept)>::Connected(std::uint32_t slot, std::uint32_t generation) const
 {
-    PriorityQueue<Delegate<Ret(Args...)>> queue;
+    return slot < mSlots.size() && mSlots[slot].generation == generation;
+}
 
-    while (!mDelegates.Empty())
-    {
-        if (mDelegates.Peek().mCallableWrapper == callableWrapper)
-            mDelegates.Remove();
-        else
-        {
-            queue.Insert(std::move(const_cast<Delegate<Ret(Args...)>&>(mDelegates.Peek())));
-            mDelegates.Remove();
-        }
-    }
+// disconnecting is O(1) amortized: the delegate is left as a tombstone (skipped when emitting) until the tombstones are 
+// half the delegates
+template <typename Ret, typename... Args, bool NoExcept>
+void Signal<Ret(Args...) noexcept(NoExcept)>::Disconnect(std::uint32_t slot, std::uint32_t generation)
+{
+    if (!Connected(slot, generation))
+        return;
 
-    while (!queue.Empty())
-    {
-        mDelegates.Insert(std::move(const_cast<Delegate<Ret(Args...)>&>(queue.Peek())));
-        queue.Remove();
-    }
+    std::uint32_t index = mSlots[slot].index;
+
+    // pending delegates are discarded at the end of the emission
+    if (index & Pending)
+        mPendingSlots[index & ~Pending] = NoSlot;
+    else
+        Tombstone(index);
+
+    FreeSlot(slot);
 }
 
-template <typename Ret, typename... Args>
-void Signal<Ret(Args...)>::operator()(Args... args) 
+// the tombstone keeps the delegate's priority (so the delegates stay sorted), a delegate that may be running is only 
+// destroyed at the end of the emission
+template <typename Ret, typename... Args, bool NoExcept>
+void Signal<Ret(Args...) noexcept(NoExcept)>::Tombstone(std::size_t index)
+{
+    if (mEmitting)
+        mDeadDelegates.push_back(std::uint32_t(index));
+    else
+        mDelegates[index].Reset();
+
+    mDelegateSlots[index] = NoSlot;
+    mTombstones++;
+
+    if (!mEmitting && 2 * mTombstones > mDelegates.size())
+        Compact();
+}
+
+// while emitting the delegates don't move: the delegate is moved at the end of the outermost emission
+template <typename Ret, typename... Args, bool NoExcept>
+void Signal<Ret(Args...) noexcept(NoExcept)>::SetPriority(std::uint32_t slot, std::uint32_t generation, unsigned int priority)
+{
+    if (!Connected(slot, generation))
+        return;
+
+    std::uint32_t index = mSlots[slot].index;
+
+    if (index & Pending)
+        mPendingDelegates[index & ~Pending].mPriority = priority;
+    else if (mEmitting)
+        mReprioritized.push_back(Reprioritization{ slot, generation, priority });
+    else
+        Reposition(index, priority);
+}
+
+template <typename Ret, typename... Args, bool NoExcept>
+void Signal<Ret(Args...) noexcept(NoExcept)>::operator()(Args... args) 
 {
     Invoke(std::forward<Args>(args)...);
 }
     
-template <typename Ret, typename... Args>
-void Signal<Ret(Args...)>::Invoke(Args... args) 
+template <typename Ret, typename... Args, bool NoExcept>
+void Signal<Ret(Args...) noexcept(NoExcept)>::Invoke(Args... args) 
 {
-    PriorityQueue<Delegate<Ret(Args...)>> queue;
+    mEmitting++;
 
-    while (!mDelegates.Empty())
+    // the delegates don't move while emitting (binding and disconnecting are deferred)
+    try
     {
-        mDelegates.Peek()(std::forward<Args>(args)...);
-        
-        queue.Insert(std::move(const_cast<Delegate<Ret(Args...)>&>(mDelegates.Peek())));
-        mDelegates.Remove();
+        for (std::size_t i = 0; i < mDelegates.size(); i++)
+            if (mDelegateSlots[i] != NoSlot)
+                mDelegates[i](static_cast<Relayed<Args>>(args)...);
     }
-
-    while (!queue.Empty())
+    catch (...)
     {
-        mDelegates.Insert(std::move(const_cast<Delegate<Ret(Args...)>&>(queue.Peek())));
-        queue.Remove();
+        EndEmission();
+        throw;
     }
+
+    EndEmission();
 }
 
-template <typename Ret, typename... Args>
+template <typename Ret, typename... Args, bool NoExcept>
 template <typename F>
-void Signal<Ret(Args...)>::operator()(const F &f, Args... args)
+void Signal<Ret(Args...) noexcept(NoExcept)>::operator()(const F &f, Args... args)
 {
     Invoke(f, std::forward<Args>(args)...);
 }
 
-template <typename Ret, typename... Args>
+template <typename Ret, typename... Args, bool NoExcept>
 template <typename F>
-void Signal<Ret(Args...)>::Invoke(const F &f, Args... args)
+void Signal<Ret(Args...) noexcept(NoExcept)>::Invoke(const F &f, Args... args)
 {
-    PriorityQueue<Delegate<Ret(Args...)>> queue;
+    mEmitting++;
 
-    while (!mDelegates.Empty())
+    try
+    {
+        for (std::size_t i = 0; i < mDelegates.size(); i++)
+            if (mDelegateSlots[i] != NoSlot && f(mDelegates[i](static_cast<Relayed<Args>>(args)...)))
+                break;
+    }
+    catch (...)
     {
-        if (f(mDelegates.Peek()(std::forward<Args>(args)...)))
+        EndEmission();
+        throw;
+    }
+
+    EndEmission();
+}
+
+template <typename Ret, typename... Args, bool NoExcept>
+void Signal<Ret(Args...) noexcept(NoExcept)>::InvokeParallel(ThreadPool &pool, Args... args)
+{
+    mEmitting++;
+
+    try
+    {
+        // one parallel loop per priority level
+        for (std::size_t begin = 0, end; begin < mDelegates.size(); begin = end)
         {
-            queue.Insert(std::move(const_cast<Delegate<Ret(Args...)>&>(mDelegates.Peek())));
-            mDelegates.Remove();
+            for (end = begin + 1; end < mDelegates.size() && mDelegates[end].mPriority == mDelegates[begin].mPriority; end++)
+                ;
+
+            pool.ParallelFor(end - begin, THREAD_POOL_GRAIN, [&, begin](std::size_t first, std::size_t last)
+            {
+                for (std::size_t i = begin + first; i < begin + last; i++)
+                    if (mDelegateSlots[i] != NoSlot)
+                        mDelegates[i](static_cast<Relayed<Args>>(args)...);
+            });
+        }
+    }
+    catch (...)
+    {
+        EndEmission();
+        throw;
+    }
+
+    EndEmission();
+}
+
+template <typename Ret, typename... Args, bool NoExcept>
+Connection Signal<Ret(Args...) noexcept(NoExcept)>::Insert(Delegate<Ret(Args...) noexcept(NoExcept)> &&delegate)
+{
+    if (mFreeSlot == NoSlot)
+    {
+        mSlots.push_back(Slot{ NoSlot, 1 });
+        mFreeSlot = std::uint32_t(mSlots.size() - 1);
+    }
+
+    std::uint32_t slot = mFreeSlot;
+
+    // delegates bound while emitting are inserted at the end of the outermost emission
+    if (mEmitting)
+    {
+        mPendingDelegates.push_back(std::move(delegate));
+
+        try
+        {
+            mPendingSlots.push_back(slot);
+        }
+        catch (...)
+        {
+            mPendingDelegates.pop_back();
+            throw;
+        }
+
+        mFreeSlot = mSlots[slot].index;
+        mSlots[slot].index = std::uint32_t(mPendingDelegates.size() - 1) | Pending;
+    }
+    else
+    {
+        mFreeSlot = mSlots[slot].index;
 
-            break;
+        try
+        {
+            Place(std::move(delegate), slot);
         }
-        else
+        catch (...)
         {
-            queue.Insert(std::move(const_cast<Delegate<Ret(Args...)>&>(mDelegates.Peek())));
-            mDelegates.Remove();
+            mSlots[slot].index = mFreeSlot;
+            mFreeSlot = slot;
+            throw;
         }
     }
 
-    while (!queue.Empty())
+    return Connection(this, slot, mSlots[slot].generation);
+}
+
+// insert the delegate after the delegates with a higher or the same priority
+template <typename Ret, typename... Args, bool NoExcept>
+void Signal<Ret(Args...) noexcept(NoExcept)>::Place(Delegate<Ret(Args...) noexcept(NoExcept)> &&delegate, std::uint32_t slot)
+{
+    std::size_t index = UpperBound(0, mDelegates.size(), delegate.mPriority);
+
+    mDelegates.insert(mDelegates.begin() + index, std::move(delegate));
+
+    try
+    {
+        mDelegateSlots.insert(mDelegateSlots.begin() + index, slot);
+    }
+    catch (...)
+    {
+        mDelegates.erase(mDelegates.begin() + index);
+        throw;
+    }
+
+    UpdateSlots(index, mDelegates.size());
+}
+
+// move the delegate after the delegates with a higher or the same priority (as if it was bound now), 
+// rotating the delegates in between: O(log n) to find the position plus the number of delegates in between
+template <typename Ret, typename... Args, bool NoExcept>
+void Signal<Ret(Args...) noexcept(NoExcept)>::Reposition(std::size_t index, unsigned int priority)
+{
+    std::size_t first, last;
+
+    if (priority > mDelegates[index].mPriority)
     {
-        mDelegates.Insert(std::move(const_cast<Delegate<Ret(Args...)>&>(queue.Peek())));
-        queue.Remove();
+        first = UpperBound(0, index, priority);
+        last = index + 1;
+
+        std::rotate(mDelegates.begin() + first, mDelegates.begin() + index, mDelegates.begin() + last);
+        std::rotate(mDelegateSlots.begin() + first, mDelegateSlots.begin() + index, mDelegateSlots.begin() + last);
+        mDelegates[first].mPriority = priority;
     }
+    else
+    {
+        first = index;
+        last = UpperBound(index + 1, mDelegates.size(), priority);
+
+        std::rotate(mDelegates.begin() + first, mDelegates.begin() + index + 1, mDelegates.begin() + last);
+        std::rotate(mDelegateSlots.begin() + first, mDelegateSlots.begin() + index + 1, mDelegateSlots.begin() + last);
+        mDelegates[last - 1].mPriority = priority;
+    }
+
+    UpdateSlots(first, last);
 }
 
-template <typename Ret, typename... Args>
-void Signal<Ret(Args...)>::Clear()
+// position of the first delegate in [first, last) with a lower priority
+template <typename Ret, typename... Args, bool NoExcept>
+std::size_t Signal<Ret(Args...) noexcept(NoExcept)>::UpperBound(std::size_t first, std::size_t last, unsigned int priority) const
 {
-    while (!mDelegates.Empty())
-        mDelegates.Remove();
+    return std::upper_bound(mDelegates.begin() + first, mDelegates.begin() + last, priority, [](unsigned int priority, auto const &delegate) { return priority > delegate.mPriority; }) - mDelegates.begin();
+}
+
+// point the slots of the delegates in [first, last) to their delegates
+template <typename Ret, typename... Args, bool NoExcept>
+void Signal<Ret(Args...) noexcept(NoExcept)>::UpdateSlots(std::size_t first, std::size_t last)
+{
+    for (std::size_t i = first; i < last; i++)
+        if (mDelegateSlots[i] != NoSlot)
+            mSlots[mDelegateSlots[i]].index = std::uint32_t(i);
+}
+
+// invalidate the connections to the slot and put it in the free list
+template <typename Ret, typename... Args, bool NoExcept>
+void Signal<Ret(Args...) noexcept(NoExcept)>::FreeSlot(std::uint32_t slot)
+{
+    if (++mSlots[slot].generation == 0)     // generation 0 is reserved for null connections
+        mSlots[slot].generation = 1;
+
+    mSlots[slot].index = mFreeSlot;
+    mFreeSlot = slot;
+}
+
+template <typename Ret, typename... Args, bool NoExcept>
+void Signal<Ret(Args...) noexcept(NoExcept)>::Clear()
+{
+    for (std::uint32_t &slot : mDelegateSlots)
+        if (slot != NoSlot)
+        {
+            FreeSlot(slot);
+
+            // the delegates may be running: they're destroyed at the end of the emission
+            if (mEmitting)
+            {
+                mDeadDelegates.push_back(std::uint32_t(&slot - mDelegateSlots.data()));
+                slot = NoSlot;
+                mTombstones++;
+            }
+        }
+
+    for (std::uint32_t slot : mPendingSlots)
+        if (slot != NoSlot)
+            FreeSlot(slot);
+
+    mPendingDelegates.clear();
+    mPendingSlots.clear();
+
+    if (!mEmitting)
+    {
+        mDelegates.clear();
+        mDelegateSlots.clear();
+        mTombstones = 0;
+    }
+}
+
+// after the outermost emission destroy the disconnected delegates (removing the tombstones once they're half the delegates), 
+// move the reprioritized ones and insert the pending ones
+template <typename Ret, typename... Args, bool NoExcept>
+void Signal<Ret(Args...) noexcept(NoExcept)>::EndEmission()
+{
+    if (--mEmitting)
+        return;
+
+    for (std::uint32_t index : mDeadDelegates)
+        mDelegates[index].Reset();
+
+    mDeadDelegates.clear();
+
+    if (2 * mTombstones > mDelegates.size())
+        Compact();
+
+    for (Reprioritization const &reprioritization : mReprioritized)
+        if (Connected(reprioritization.slot, reprioritization.generation))
+            Reposition(mSlots[reprioritization.slot].index, reprioritization.priority);
+
+    mReprioritized.clear();
+
+    for (std::size_t i = 0; i < mPendingDelegates.size(); i++)
+        if (mPendingSlots[i] != NoSlot)
+            Place(std::move(mPendingDelegates[i]), mPendingSlots[i]);
+
+    mPendingDelegates.clear();
+    mPendingSlots.clear();
+}
+
+// remove all the tombstones in a single pass (keeping the order)
+template <typename Ret, typename... Args, bool NoExcept>
+void Signal<Ret(Args...) noexcept(NoExcept)>::Compact()
+{
+    std::size_t size = 0;
+
+    for (std::size_t i = 0; i < mDelegates.size(); i++)
+        if (mDelegateSlots[i] != NoSlot)
+        {
+            if (i != size)
+            {
+                mDelegates[size] = std::move(mDelegates[i]);
+                mDelegateSlots[size] = mDelegateSlots[i];
+                mSlots[mDelegateSlots[size]].index = std::uint32_t(size);
+            }
+
+            size++;
+        }
+
+    mDelegates.erase(mDelegates.begin() + size, mDelegates.end());
+    mDelegateSlots.erase(mDelegateSlots.begin() + size, mDelegateSlots.end());
+    mTombstones = 0;
 }
 
 #endif  // SIGNAL_H
\ No newline at end of file
@@ -1,17 +1,32 @@
 #ifndef CALLABLE_WRAPPER_H
 #define CALLABLE_WRAPPER_H
 
+#include <functional>
+#include <type_traits>
+#include "callable_pool.hpp"
+
 /***** base callable wrapper class *****/
 template <typename Signature>
 class CallableWrapper;
 
-template <typename Ret, typename... Args>
-class CallableWrapper<Ret(Args...)>
+template <typename Ret, typename... Args, bool NoExcept>
+class CallableWrapper<Ret(Args...) noexcept(NoExcept)>
 {
 public:
     virtual ~CallableWrapper() = default;
 
-    virtual Ret Invoke(Args... args) = 0;
+    virtual Ret Invoke(Args... args) noexcept(NoExcept) = 0;
+
+    // move constructs the wrapper in storage (wrappers stored inside a delegate are moved with it)
+    virtual CallableWrapper *MoveTo(void *storage) noexcept = 0;
+
+    // wrappers are allocated from the callable pool (the sized delete gets the size of the most derived wrapper)
+    static void *operator new(std::size_t size) { return CallablePool::Allocate(size); }
+    static void operator delete(void *ptr, std::size_t size) noexcept { CallablePool::Deallocate(ptr, size); }
+
+    // over-aligned wrappers (function objects with over-aligned captures) bypass the pool, whose blocks are only aligned to max_align_t
+    static void *operator new(std::size_t size, std::align_val_t alignment) { return ::operator new(size, alignment); }
+    static void operator delete(void *ptr, std::size_t size, std::align_val_t alignment) noexcept { ::operator delete(ptr, size, alignment); }
 protected:
     CallableWrapper() = default;
 };
@@ -56,40 +71,37 @@ protected:
 template <typename Signature, typename T, typename PtrToMemFun>
 class MemFunCallableWrapper;
 
-template <typename Ret, typename... Args, typename T, typename PtrToMemFun>
-class MemFunCallableWrapper<Ret(Args...), T, PtrToMemFun> : public CallableWrapper<Ret(Args...)>
+template <typename Ret, typename... Args, bool NoExcept, typename T, typename PtrToMemFun>
+class MemFunCallableWrapper<Ret(Args...) noexcept(NoExcept), T, PtrToMemFun> : public CallableWrapper<Ret(Args...) noexcept(NoExcept)>
 {
 public:
     MemFunCallableWrapper(T &instance, PtrToMemFun ptrToMemFun) : mInstance(instance), mPtrToMemFun(ptrToMemFun) {}
 
-    Ret Invoke(Args... args) override {  return (mInstance.*mPtrToMemFun)(std::forward<Args>(args)...); }
+    Ret Invoke(Args... args) noexcept(NoExcept) override {  return (mInstance.*mPtrToMemFun)(std::forward<Args>(args)...); }
+
+    CallableWrapper<Ret(Args...) noexcept(NoExcept)> *MoveTo(void *storage) noexcept override { return ::new(storage) MemFunCallableWrapper(std::move(*this)); }
 private:
     T &mInstance;
     PtrToMemFun mPtrToMemFun;
 };
 
 /***** wrapper around a function object/lambda *****/
+// T is an lvalue reference type for function objects bound as lvalues (the wrapper refers to them), otherwise the function 
+// object is moved into the wrapper (one allocation per bind at most, the function object is called without an indirection)
 template <typename Signature, typename T>
 class FunObjCallableWrapper;
 
-template <typename Ret, typename... Args, typename T>
-class FunObjCallableWrapper<Ret(Args...), T> : public CallableWrapper<Ret(Args...)>
+template <typename Ret, typename... Args, bool NoExcept, typename T>
+class FunObjCallableWrapper<Ret(Args...) noexcept(NoExcept), T> : public CallableWrapper<Ret(Args...) noexcept(NoExcept)>
 {
 public:
-    FunObjCallableWrapper(T &funObject) : mFunObject(&funObject), mAllocated(false) {}
-    FunObjCallableWrapper(T &&funObject) : mFunObject(new T(std::move(funObject))), mAllocated(true) {} 
+    FunObjCallableWrapper(T &&funObject) : mFunObject(std::forward<T>(funObject)) {}
 
-    ~FunObjCallableWrapper() { Destroy(); }
+    Ret Invoke(Args... args) noexcept(NoExcept) override { return mFunObject(std::forward<Args>(args)...); }
 
-    Ret Invoke(Args... args) override { return (*mFunObject)(std::forward<Args>(args)...); }
+    CallableWrapper<Ret(Args...) noexcept(NoExcept)> *MoveTo(void *storage) noexcept override { return ::new(storage) FunObjCallableWrapper(std::move(*this)); }
 private:
-    template <typename U = T, typename = std::enable_if_t<std::is_function<U>::value>>                  // dummy type param defaulted to T (SFINAE)
-    void Destroy() {}
-    template <typename U = T, typename = std::enable_if_t<!std::is_function<U>::value>, typename = T>   // dummy type param defaulted to T (SFINAE) + extra type param (for overloading)
-    void Destroy() { if (mAllocated) delete mFunObject; }                                               // SFINAE-out if T has function type
-
-    T *mFunObject;
-    bool mAllocated;
+    std::conditional_t<std::is_lvalue_reference<T>::value, std::reference_wrapper<std::remove_reference_t<T>>, T> mFunObject;
 };
 
 #endif  // CALLABLE_WRAPPER_H
\ No newline at end of file
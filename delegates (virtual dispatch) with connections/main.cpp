@@ -17,7 +17,7 @@ public:
         mConnections.push_back(sig.Bind(*static_cast<MyClass const*>(this)));
     }
 
-    ~MyClass() { for (auto &connection : mConnections) connection.Disconnect(); }
+    ~MyClass() { for (auto &connection : mConnections) sig.Disconnect(connection); }
 
     int MemberFunction(int d) { std::cout << "in member function" << std::endl; return int(++i * d); }
     int ConstMemberFunction(double d) const { std::cout << "in const member function" << std::endl; return int(i * d); }
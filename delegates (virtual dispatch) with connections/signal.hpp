@@ -3,8 +3,15 @@
 
 #include <vector>
 #include <type_traits>
+#include <cstdint>
+#include <tuple>
 #include "delegate.hpp"
 
+#ifdef __cpp_impl_coroutine
+#include <coroutine>
+#include <optional>
+#endif
+
 /***** signal typedefs *****/
 #define SIGNAL(SignalType)                                  typedef Signal<void()> SignalType
 #define SIGNAL_ONE_PARAM(SignalType, par0)                  typedef Signal<void(par0)> SignalType
@@ -14,15 +21,20 @@
 #define SIGNAL_RET_ONE_PARAM(SignalType, ret, par0)         typedef Signal<ret(par0)> SignalType
 #define SIGNAL_RET_TWO_PARAM(SignalType, ret, par0, par1)   typedef Signal<ret(par0, par1)> SignalType
 
+/**** argument passed on to several delegates ****/
+// reference parameters are forwarded, parameters taken by value are passed as lvalues (so the delegates called later 
+// don't get moved-from values)
+template <typename Arg>
+using Relayed = std::conditional_t<std::is_reference_v<Arg>, Arg&&, Arg&>;
+
 /**** signal primary class template (not defined) ****/
 template <typename Signature>
 class Signal;
 
 /**** signal partial class template specialization for function types ****/
-template <typename Ret, typename... Args>
-class Signal<Ret(Args...)>  
+template <typename Ret, typename... Args, bool NoExcept>
+class Signal<Ret(Args...) noexcept(NoExcept)>  
 {
-friend class Connection;
 public:
     // template <typename T>
     // Connection Bind(T &instance, Ret (T::*ptrToMemFun)(Args...));
@@ -43,15 +55,95 @@ public:
     template <typename T>
     Connection Bind(T &&funObj);
 
-    explicit operator bool() const { return !mDelegates.empty(); }
+    // disconnecting is O(1) amortized and keeps the call order (the delegate is destroyed and leaves a tombstone, tombstones 
+    // are removed when they're half of the delegates), returns false if the connection is stale (already disconnected, 
+    // signal cleared or connection to another signal)
+    bool Disconnect(Connection const &connection);
+
+    bool Connected(Connection const &connection) const;
+
+    void Clear();
+
+    explicit operator bool() const { return mDelegates.size() != mTombstones || !mPendingDelegates.empty(); }
 
-    void operator()(Args... args) { for (auto &delegate : mDelegates) delegate(std::forward<Args>(args)...); }  
+    // binding, disconnecting and clearing are allowed while emitting (from inside the delegates): disconnected delegates 
+    // are skipped and removed after the outermost emission, delegates bound while emitting are called from the next emission
+    void operator()(Args... args) noexcept(NoExcept);
     
-    void Invoke(Args... args) { for (auto &delegate : mDelegates) delegate.Invoke(std::forward<Args>(args)...); }
+    void Invoke(Args... args) noexcept(NoExcept);
+
+#ifdef __cpp_impl_coroutine
+    class Awaiter;
+
+    // co_await signal.Next() (or co_await signal) suspends the coroutine until the next emission and returns a tuple with 
+    // the emission's arguments; coroutines are resumed by the emitting thread after the delegates are called 
+    // (coroutines awaiting a signal that's destroyed are never resumed)
+    Awaiter Next() { return Awaiter(*this); }
+    Awaiter operator co_await() { return Next(); }
+#endif
 private:
-    void Unbind(CallableWrapper<Ret(Args...)> *callableWrapper);
+    struct AwaiterList;
+
+    // intrusive list of the coroutines awaiting the next emission (no allocation per awaiting coroutine)
+    struct AwaiterNode
+    {
+        AwaiterNode *prev = nullptr;
+        AwaiterNode *next = nullptr;
+        AwaiterList *list = nullptr;       // list the node is linked to (null if not linked)
+        void (*notify)(AwaiterNode *node, Args... args) = nullptr;
+
+        void Link(AwaiterList &awaiters);  // appends, coroutines are resumed in the order they started awaiting
+        void Unlink();
+    };
+
+    // ends of an awaiter list (moving a signal moves its awaiters, destroying it unlinks them)
+    struct AwaiterList
+    {
+        AwaiterNode *head = nullptr;
+        AwaiterNode *tail = nullptr;
+
+        AwaiterList() = default;
+        AwaiterList(AwaiterList &&other) : head(other.head), tail(other.tail) { other.head = other.tail = nullptr; Relink(); }
+        ~AwaiterList() { while (head) head->Unlink(); }
+        AwaiterList &operator=(AwaiterList &&other);
+
+        void Append(AwaiterList &other);    // moves the nodes of other after the ones of this list
+        void Relink() { for (AwaiterNode *node = head; node; node = node->next) node->list = this; }
+    };
+
+
+    // slot map: delegates are kept in a dense array, connections refer to slots in a sparse array that track their delegate's position
+    struct Slot
+    {
+        std::uint32_t index;        // position in mDelegates (next free slot if the slot is free)
+        std::uint32_t generation;   
+    };
+
+    static constexpr std::uint32_t NoSlot = std::uint32_t(-1);
+    static constexpr std::uint32_t Pending = std::uint32_t(1) << 31;     // set in the index of the slots of pending delegates
+
+    std::vector<Delegate<Ret(Args...) noexcept(NoExcept)>> mDelegates;
+    std::vector<std::uint32_t> mDelegateSlots;     // slot of each delegate in mDelegates (NoSlot if disconnected)
+    std::vector<Slot> mSlots;
+    std::uint32_t mFreeSlot = NoSlot;             // head of the free slot list
+    std::uint32_t mSalt = Connection::NextSalt(); // generation of new slots (differs between signals, so connections to other signals don't match)
+
+    // state of the emission in progress
+    std::uint32_t mEmitting = 0;                                                    // depth of nested emissions
+    std::size_t mTombstones = 0;                                                    // disconnected delegates not removed yet
+    std::vector<std::uint32_t> mDeadDelegates;                                      // positions of the delegates disconnected while emitting
+    std::vector<Delegate<Ret(Args...) noexcept(NoExcept)>> mPendingDelegates;      // delegates bound while emitting
+    std::vector<std::uint32_t> mPendingSlots;
 
-    std::vector<Delegate<Ret(Args...)>> mDelegates;
+    AwaiterList mAwaiters;      // coroutines awaiting the next emission
+
+    Connection Insert(Delegate<Ret(Args...) noexcept(NoExcept)> &&delegate);
+    void FreeSlot(std::uint32_t slot);
+    void Tombstone(std::size_t index);
+
+    void EndEmission();
+    void Compact();
+    void Resume(Args... args);
 };
 
 // template <typename Ret, typename... Args>
@@ -76,37 +168,384 @@ private:
 //     return Connection(this, mDelegates.back().mCallableWrapper); 
 // }
 
-template <typename Ret, typename... Args>
+template <typename Ret, typename... Args, bool NoExcept>
 template <typename T, typename PtrToMemFun>
-std::enable_if_t<std::is_member_function_pointer_v<PtrToMemFun>, Connection> Signal<Ret(Args...)>::Bind(T &instance, PtrToMemFun ptrToMemFun)
+std::enable_if_t<std::is_member_function_pointer_v<PtrToMemFun>, Connection> Signal<Ret(Args...) noexcept(NoExcept)>::Bind(T &instance, PtrToMemFun ptrToMemFun)
 {
-    Delegate<Ret(Args...)> delegate;
-    mDelegates.push_back(std::move(delegate));
-    mDelegates.back().Bind(instance, ptrToMemFun);
+    Delegate<Ret(Args...) noexcept(NoExcept)> delegate;
+    delegate.Bind(instance, ptrToMemFun);
 
-    return Connection(this, mDelegates.back().mCallableWrapper); 
+    return Insert(std::move(delegate)); 
 }
     
-template <typename Ret, typename... Args>
+template <typename Ret, typename... Args, bool NoExcept>
 template <typename T>
-Connection Signal<Ret(Args...)>::Bind(T &&funObj)
+Connection Signal<Ret(Args...) noexcept(NoExcept)>::Bind(T &&funObj)
+{
+    Delegate<Ret(Args...) noexcept(NoExcept)> delegate;
+    delegate.Bind(std::forward<T>(funObj));
+
+    return Insert(std::move(delegate)); 
+}
+
+template <typename Ret, typename... Args, bool NoExcept>
+bool Signal<Ret(Args...) noexcept(NoExcept)>::Disconnect(Connection const &connection)
+{
+    if (!Connected(connection))
+        return false;
+
+    std::uint32_t index = mSlots[connection.mSlot].index;
+
+    // pending delegates aren't running and are discarded at the end of the emission
+    if (index & Pending)
+        mPendingSlots[index & ~Pending] = NoSlot;
+    else
+        Tombstone(index);
+
+    FreeSlot(connection.mSlot);
+
+    return true;
+}
+
+template <typename Ret, typename... Args, bool NoExcept>
+bool Signal<Ret(Args...) noexcept(NoExcept)>::Connected(Connection const &connection) const
+{
+    return connection.mSlot < mSlots.size() && mSlots[connection.mSlot].generation == connection.mGeneration;
+}
+
+template <typename Ret, typename... Args, bool NoExcept>
+void Signal<Ret(Args...) noexcept(NoExcept)>::Clear()
+{
+    if (mEmitting)
+        mDeadDelegates.reserve(mDelegates.size());
+
+    for (std::size_t i = 0; i < mDelegateSlots.size(); i++)
+        if (mDelegateSlots[i] != NoSlot)
+        {
+            FreeSlot(mDelegateSlots[i]);
+
+            if (mEmitting)
+            {
+                mDelegateSlots[i] = NoSlot;
+                mTombstones++;
+                mDeadDelegates.push_back(std::uint32_t(i));
+            }
+        }
+
+    for (std::uint32_t slot : mPendingSlots)
+        if (slot != NoSlot)
+            FreeSlot(slot);
+
+    mPendingDelegates.clear();
+    mPendingSlots.clear();
+
+    if (!mEmitting)
+    {
+        mDelegates.clear();
+        mDelegateSlots.clear();
+        mTombstones = 0;
+    }
+}
+
+template <typename Ret, typename... Args, bool NoExcept>
+void Signal<Ret(Args...) noexcept(NoExcept)>::operator()(Args... args) noexcept(NoExcept)
+{
+    mEmitting++;
+
+    try
+    {
+        // the size is fixed: delegates bound while emitting are pending
+        for (std::size_t i = 0, size = mDelegates.size(); i < size; i++)
+            if (mDelegateSlots[i] != NoSlot)
+                mDelegates[i](static_cast<Relayed<Args>>(args)...);
+    }
+    catch (...)
+    {
+        EndEmission();
+
+        if constexpr (!NoExcept)    // (delegates with noexcept signatures don't throw)
+            throw;
+
+        return;     // the emission has already been ended
+    }
+
+    EndEmission();
+
+    if (mAwaiters.head)
+        Resume(static_cast<Relayed<Args>>(args)...);
+}
+
+template <typename Ret, typename... Args, bool NoExcept>
+void Signal<Ret(Args...) noexcept(NoExcept)>::Invoke(Args... args) noexcept(NoExcept)
+{
+    mEmitting++;
+
+    try
+    {
+        for (std::size_t i = 0, size = mDelegates.size(); i < size; i++)
+            if (mDelegateSlots[i] != NoSlot)
+                mDelegates[i].Invoke(static_cast<Relayed<Args>>(args)...);
+    }
+    catch (...)
+    {
+        EndEmission();
+
+        if constexpr (!NoExcept)    // (delegates with noexcept signatures don't throw)
+            throw;
+
+        return;     // the emission has already been ended
+    }
+
+    EndEmission();
+
+    if (mAwaiters.head)
+        Resume(static_cast<Relayed<Args>>(args)...);
+}
+
+template <typename Ret, typename... Args, bool NoExcept>
+Connection Signal<Ret(Args...) noexcept(NoExcept)>::Insert(Delegate<Ret(Args...) noexcept(NoExcept)> &&delegate)
+{
+    if (mFreeSlot == NoSlot)
+    {
+        mSlots.push_back(Slot{ NoSlot, mSalt });
+        mFreeSlot = std::uint32_t(mSlots.size() - 1);
+    }
+
+    std::uint32_t slot = mFreeSlot;
+
+    // delegates bound while emitting are appended at the end of the outermost emission
+    std::vector<Delegate<Ret(Args...) noexcept(NoExcept)>> &delegates = mEmitting ? mPendingDelegates : mDelegates;
+    std::vector<std::uint32_t> &delegateSlots = mEmitting ? mPendingSlots : mDelegateSlots;
+
+    delegates.push_back(std::move(delegate));
+
+    try
+    {
+        delegateSlots.push_back(slot);
+    }
+    catch (...)
+    {
+        delegates.pop_back();
+        throw;
+    }
+
+    mFreeSlot = mSlots[slot].index;
+    mSlots[slot].index = std::uint32_t(delegates.size() - 1) | (mEmitting ? Pending : 0);
+
+    return Connection(slot, mSlots[slot].generation);
+}
+
+// invalidate the connections to the slot and put it in the free list
+template <typename Ret, typename... Args, bool NoExcept>
+void Signal<Ret(Args...) noexcept(NoExcept)>::FreeSlot(std::uint32_t slot)
 {
-    Delegate<Ret(Args...)> delegate;
-    mDelegates.push_back(std::move(delegate));
-    mDelegates.back().Bind(std::forward<T>(funObj));
+    if (++mSlots[slot].generation == 0)     // generation 0 is reserved for null connections
+        mSlots[slot].generation = 1;
 
-    return Connection(this, mDelegates.back().mCallableWrapper); 
+    mSlots[slot].index = mFreeSlot;
+    mFreeSlot = slot;
 }
 
-template <typename Ret, typename... Args>
-void Signal<Ret(Args...)>::Unbind(CallableWrapper<Ret(Args...)> *callableWrapper)
+// the delegate at index is skipped from now on: a delegate that may be running (disconnected while emitting) is destroyed
+// at the end of the outermost emission, the others right away
+template <typename Ret, typename... Args, bool NoExcept>
+void Signal<Ret(Args...) noexcept(NoExcept)>::Tombstone(std::size_t index)
 {
-    for (auto it = mDelegates.begin(), end = mDelegates.end(); it != end; ++it)
-        if (it->mCallableWrapper == callableWrapper)
+    if (mEmitting)
+        mDeadDelegates.push_back(std::uint32_t(index));
+    else
+        mDelegates[index].Reset();
+
+    mDelegateSlots[index] = NoSlot;
+    mTombstones++;
+
+    if (!mEmitting && 2 * mTombstones > mDelegates.size())
+        Compact();
+}
+
+// resume the coroutines awaiting the emission (coroutines awaiting again are resumed by the next emission)
+template <typename Ret, typename... Args, bool NoExcept>
+void Signal<Ret(Args...) noexcept(NoExcept)>::Resume(Args... args)
+{
+    AwaiterList resuming(std::move(mAwaiters));
+
+    while (resuming.head)
+    {
+        AwaiterNode *node = resuming.head;
+        node->Unlink();
+
+        try
+        {
+            node->notify(node, static_cast<Relayed<Args>>(args)...);
+        }
+        catch (...)
         {
-            mDelegates.erase(it);
-            return;
+            // the coroutines not resumed yet wait for the next emission (ahead of the ones that started awaiting meanwhile)
+            resuming.Append(mAwaiters);
+            mAwaiters = std::move(resuming);
+
+            throw;
         }
+    }
+}
+
+template <typename Ret, typename... Args, bool NoExcept>
+void Signal<Ret(Args...) noexcept(NoExcept)>::AwaiterNode::Link(AwaiterList &awaiters)
+{
+    prev = awaiters.tail;
+    next = nullptr;
+    list = &awaiters;
+
+    if (prev)
+        prev->next = this;
+    else
+        awaiters.head = this;
+
+    awaiters.tail = this;
+}
+
+template <typename Ret, typename... Args, bool NoExcept>
+void Signal<Ret(Args...) noexcept(NoExcept)>::AwaiterNode::Unlink()
+{
+    if (prev)
+        prev->next = next;
+    else
+        list->head = next;
+
+    if (next)
+        next->prev = prev;
+    else
+        list->tail = prev;
+
+    prev = next = nullptr;
+    list = nullptr;
+}
+
+template <typename Ret, typename... Args, bool NoExcept>
+typename Signal<Ret(Args...) noexcept(NoExcept)>::AwaiterList &Signal<Ret(Args...) noexcept(NoExcept)>::AwaiterList::operator=(AwaiterList &&other)
+{
+    if (this != &other)
+    {
+        while (head)
+            head->Unlink();
+
+        head = other.head;
+        tail = other.tail;
+        other.head = other.tail = nullptr;
+        Relink();
+    }
+
+    return *this;
+}
+
+template <typename Ret, typename... Args, bool NoExcept>
+void Signal<Ret(Args...) noexcept(NoExcept)>::AwaiterList::Append(AwaiterList &other)
+{
+    if (!other.head)
+        return;
+
+    for (AwaiterNode *node = other.head; node; node = node->next)
+        node->list = this;
+
+    if (tail)
+    {
+        tail->next = other.head;
+        other.head->prev = tail;
+    }
+    else
+        head = other.head;
+
+    tail = other.tail;
+    other.head = other.tail = nullptr;
+}
+
+#ifdef __cpp_impl_coroutine
+/**** signal awaiter ****/
+template <typename Ret, typename... Args, bool NoExcept>
+class Signal<Ret(Args...) noexcept(NoExcept)>::Awaiter : private AwaiterNode
+{
+public:
+    explicit Awaiter(Signal &signal) : mSignal(signal) { this->notify = &Notify; }
+
+    Awaiter(Awaiter const&) = delete;
+
+    ~Awaiter() { if (this->list) this->Unlink(); }
+
+    Awaiter &operator=(Awaiter const&) = delete;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> coroutine) { mCoroutine = coroutine; this->Link(mSignal.mAwaiters); }
+    std::tuple<std::decay_t<Args>...> await_resume() { return std::move(*mArguments); }
+private:
+    Signal &mSignal;
+    std::coroutine_handle<> mCoroutine;
+    std::optional<std::tuple<std::decay_t<Args>...>> mArguments;
+
+    static void Notify(AwaiterNode *node, Args... args)
+    {
+        Awaiter &awaiter = static_cast<Awaiter&>(*node);
+
+        awaiter.mArguments.emplace(args...);
+        awaiter.mCoroutine.resume();
+    }
+};
+#endif
+
+// after the outermost emission destroy the delegates disconnected while emitting and append the pending delegates
+template <typename Ret, typename... Args, bool NoExcept>
+void Signal<Ret(Args...) noexcept(NoExcept)>::EndEmission()
+{
+    if (--mEmitting)
+        return;
+
+    for (std::uint32_t index : mDeadDelegates)
+        mDelegates[index].Reset();
+
+    mDeadDelegates.clear();
+
+    if (2 * mTombstones > mDelegates.size())
+        Compact();
+
+    if (mPendingDelegates.empty())
+        return;
+
+    mDelegates.reserve(mDelegates.size() + mPendingDelegates.size());
+    mDelegateSlots.reserve(mDelegateSlots.size() + mPendingSlots.size());
+
+    for (std::size_t i = 0; i < mPendingDelegates.size(); i++)
+        if (mPendingSlots[i] != NoSlot)
+        {
+            mDelegates.push_back(std::move(mPendingDelegates[i]));
+            mDelegateSlots.push_back(mPendingSlots[i]);
+            mSlots[mPendingSlots[i]].index = std::uint32_t(mDelegates.size() - 1);
+        }
+
+    mPendingDelegates.clear();
+    mPendingSlots.clear();
+}
+
+// remove all the tombstones in a single pass (keeping the call order)
+template <typename Ret, typename... Args, bool NoExcept>
+void Signal<Ret(Args...) noexcept(NoExcept)>::Compact()
+{
+    std::size_t size = 0;
+
+    for (std::size_t i = 0; i < mDelegates.size(); i++)
+        if (mDelegateSlots[i] != NoSlot)
+        {
+            if (i != size)
+            {
+                mDelegates[size] = std::move(mDelegates[i]);
+                mDelegateSlots[size] = mDelegateSlots[i];
+                mSlots[mDelegateSlots[size]].index = std::uint32_t(size);
+            }
+
+            size++;
+        }
+
+    mDelegates.erase(mDelegates.begin() + size, mDelegates.end());
+    mDelegateSlots.erase(mDelegateSlots.begin() + size, mDelegateSlots.end());
+    mTombstones = 0;
 }
 
 #endif  // SIGNAL_H
\ No newline at end of file
@@ -0,0 +1,112 @@
+// microbenchmarks of the delegates against std::function, printing one JSON object per result (see ../benchmark/benchmark.hpp)
+// built by the benchmarks target of the top level CMakeLists.txt, or by hand with optimizations, e.g. g++ -std=c++17 -O2 -DNDEBUG -pthread benchmark.cpp -o benchmark
+
+#include "delegate.hpp"
+#include "../benchmark/benchmark.hpp"
+#include <string>
+
+using SingleDelegate = Delegate<void(int)>;
+
+void BenchmarkDelegate(Benchmark const &benchmark)
+{
+    benchmark.Report("Delegate", "sizeof", 1, sizeof(SingleDelegate), "bytes");
+
+    Listener listener;
+    int argument = 1;
+
+    SingleDelegate member;
+    member.Bind<&Listener::OnEvent>(listener);
+
+    benchmark.Time("Delegate/member", "call", 1, [&]() { member(argument); });
+
+    SingleDelegate lambda;
+    lambda.Bind([&listener](int i) { listener.OnEvent(i); });
+
+    benchmark.Time("Delegate/lambda", "call", 1, [&]() { lambda(argument); });
+    DoNotOptimize(listener.value);
+
+    benchmark.Time("Delegate/lambda", "copy", 1, [&]() { SingleDelegate copy(lambda); DoNotOptimize(copy); });
+    benchmark.Time("Delegate/lambda", "move", 1, [&]() { SingleDelegate moved(std::move(lambda)); lambda = std::move(moved); DoNotOptimize(lambda); });
+}
+
+// listeners bound as member functions (one at a time and batched) and as rvalue lambdas (owned by the multicast delegates)
+template <typename Multicast>
+void BenchmarkMulticast(Benchmark const &benchmark, std::string const &name)
+{
+    std::string lambda = name + "/lambda";
+
+    benchmark.Report(name.c_str(), "sizeof", 1, sizeof(Multicast), "bytes");
+
+    std::vector<std::size_t> counts = Benchmark::ListenerCounts();
+    std::vector<Listener> listeners(counts.back());
+
+    Listener extra;
+    auto handler = [&extra](int i) { extra.OnEvent(i); };
+    int argument = 1;
+
+    auto bindMember = [](Multicast &multicast, Listener &listener, bool batched)
+    {
+        return batched ? multicast.template BindBatched<&Listener::OnEvent>(listener) : multicast.template Bind<&Listener::OnEvent>(listener);
+    };
+
+    for (std::size_t count : counts)
+    {
+        for (bool batched : { false, true })
+        {
+            std::string member = name + (batched ? "/member_batched" : "/member");
+            std::size_t heap = Benchmark::HeapBytes();
+            Multicast multicast;
+
+            for (std::size_t i = 0; i < count; i++)
+                bindMember(multicast, listeners[i], batched);
+
+            benchmark.Report(member.c_str(), "heap_per_listener", count, double(Benchmark::HeapBytes() - heap) / count, "bytes");
+
+            benchmark.Time(member.c_str(), "bind_unbind", count, [&]()
+            {
+                bindMember(multicast, extra, batched);
+                multicast.template Unbind<&Listener::OnEvent>(extra);
+            });
+
+            benchmark.Time(member.c_str(), "emit", count, [&]() { multicast(argument); });
+            benchmark.Time(member.c_str(), "copy", count, [&]() { Multicast copy(multicast); DoNotOptimize(copy); });
+            benchmark.Time(member.c_str(), "move", count, [&]() { Multicast moved(std::move(multicast)); multicast = std::move(moved); DoNotOptimize(multicast); });
+        }
+
+        {
+            std::size_t heap = Benchmark::HeapBytes();
+            Multicast multicast;
+
+            for (std::size_t i = 0; i < count; i++)
+                multicast.Bind([&target = listeners[i]](int i) { target.OnEvent(i); });
+
+            benchmark.Report(lambda.c_str(), "heap_per_listener", count, double(Benchmark::HeapBytes() - heap) / count, "bytes");
+
+            // rvalue lambdas can't be unbound, an lvalue one is bound and unbound instead
+            benchmark.Time(lambda.c_str(), "bind_unbind", count, [&]()
+            {
+                multicast.Bind(handler);
+                multicast.Unbind(handler);
+            });
+
+            benchmark.Time(lambda.c_str(), "emit", count, [&]() { multicast(argument); });
+            benchmark.Time(lambda.c_str(), "copy", count, [&]() { Multicast copy(multicast); DoNotOptimize(copy); });
+            benchmark.Time(lambda.c_str(), "move", count, [&]() { Multicast moved(std::move(multicast)); multicast = std::move(moved); DoNotOptimize(multicast); });
+        }
+    }
+
+    DoNotOptimize(listeners);
+    DoNotOptimize(extra.value);
+}
+
+int main()
+{
+    Benchmark benchmark("fast delegates 17");
+
+    BenchmarkStdFunction(benchmark);
+    BenchmarkDelegate(benchmark);
+    BenchmarkMulticast<MulticastDelegate<void(int)>>(benchmark, "MulticastDelegate");
+    BenchmarkMulticast<PackedMulticastDelegate<void(int)>>(benchmark, "PackedMulticastDelegate");
+
+    return 0;
+}
@@ -4,6 +4,30 @@
 #include <utility>
 #include <type_traits>
 #include <functional>
+#include <new>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include "thread_pool.hpp"
+
+/***** inline storage size (functors bigger than this are stored on the heap) *****/
+#ifndef DELEGATE_INLINE_SIZE
+#define DELEGATE_INLINE_SIZE sizeof(void*)
+#endif
+
+/***** unbound delegate policy (what an unbound delegate does when invoked) *****/
+#define DELEGATE_UNBOUND_THROW      0   // throw DelegateNotBoundException
+#define DELEGATE_UNBOUND_ABORT      1   // call std::abort
+#define DELEGATE_UNBOUND_DEFAULT    2   // return a value-initialized Ret
+
+#ifndef DELEGATE_UNBOUND_POLICY
+#define DELEGATE_UNBOUND_POLICY DELEGATE_UNBOUND_THROW
+#endif
 
 /***** delegate typedefs *****/
 #define DELEGATE(delegateName)                         typedef Delegate<void()> delegateName
@@ -34,32 +58,52 @@ public:
 };
 
 /**** delegate primary class template (not defined) ****/
-template <typename Signature>
+template <typename Signature, std::size_t InlineSize = DELEGATE_INLINE_SIZE>
 class Delegate;
 
 /**** namespace scope swap function ****/
-template <typename Signature>
-void swap(Delegate<Signature> &d1, Delegate<Signature> &d2)
+template <typename Signature, std::size_t InlineSize>
+void swap(Delegate<Signature, InlineSize> &d1, Delegate<Signature, InlineSize> &d2)
 {   
     d1.Swap(d2);
 }
 
+/**** forward declarations (for friend declarations inside Delegate) ****/
+template <typename Signature, std::size_t InlineSize>
+class MulticastDelegate;
+
+template <typename Signature, std::size_t InlineSize>
+class PackedMulticastDelegate;
+
+template <typename Signature, std::size_t InlineSize>
+class MemberFunctionBatches;
+
 /**** delegate partial class template for function types ****/
-template <typename Ret, typename... Args>
-class Delegate<Ret(Args...)>
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+class Delegate<Ret(Args...) noexcept(NoExcept), InlineSize>
 {
+    static_assert(InlineSize >= sizeof(void*), "inline storage must be able to hold at least a pointer");
+
+    template <typename Signature, std::size_t Size>
+    friend class MulticastDelegate;
+
+    template <typename Signature, std::size_t Size>
+    friend class PackedMulticastDelegate;
+
+    template <typename Signature, std::size_t Size>
+    friend class MemberFunctionBatches;
 public:
     Delegate();
 
     Delegate(Delegate const &other);
 
-    Delegate(Delegate &&other);
+    Delegate(Delegate &&other) noexcept;
 
     ~Delegate();
 
     Delegate &operator=(Delegate const &other);
 
-    Delegate &operator=(Delegate &&other);
+    Delegate &operator=(Delegate &&other) noexcept;
 
     template <auto FreeFunction, typename = typename std::enable_if<std::is_function<typename std::remove_pointer<decltype(FreeFunction)>::type>::value && std::is_invocable_r<Ret, decltype(FreeFunction), Args...>::value>::type>
     void Bind();
@@ -72,106 +116,156 @@ public:
 
     void Swap(Delegate &other);
 
-    explicit operator bool() const { return mFunction; } 
+    explicit operator bool() const { return mFunction != &UnboundStub; } 
+
+    // two delegates are equal if they call the same function on the same instance (delegates owning a function object are only equal to themselves)
+    bool operator==(Delegate const &other) const;
+    bool operator!=(Delegate const &other) const { return !(*this == other); }
+
+    std::size_t Hash() const;
+
+    // a trivially relocatable delegate can be moved to a new address with memcpy (no move constructor + destructor call)
+    bool IsTriviallyRelocatable() const { return !mManager || mManager->relocatable; }
 
     template <typename... FwdArgs>
-    Ret operator()(FwdArgs&&... args);
+    Ret operator()(FwdArgs&&... args) noexcept(NoExcept);
 
     template <typename... FwdArgs>
-    Ret Invoke(FwdArgs&&... args);
+    Ret Invoke(FwdArgs&&... args) noexcept(NoExcept);
 private:
     //typedef typename std::aligned_storage<sizeof(void*), alignof(void*)>::type Storage;
-    using Storage = std::aligned_storage_t<sizeof(void*), alignof(void*)> ;
-    using Function = Ret(*)(Storage /*void*/ *, Args...);
+    using Storage = std::aligned_storage_t<InlineSize, alignof(void*)> ;
+    using Function = Ret(*)(Storage /*void*/ *, Args...) noexcept(NoExcept);
     
+    using DestroyStorageFunction = void(*)(Storage*);
+    using CopyStorageFunction = void(*)(const Storage*, Storage*);
+    using MoveStorageFunction = void(*)(Storage*, Storage*);
+
+    // lifetime functions of a stored function object (one static table per stored type)
+    struct StorageManager
+    {
+        DestroyStorageFunction destroy;
+        CopyStorageFunction copy;
+        MoveStorageFunction move;
+        bool relocatable;       // the stored object can be moved with memcpy
+    };
+
     Storage mData;
     Function mFunction;
 
-    bool mStored = false;
+    StorageManager const *mManager = nullptr;   // null if the storage is trivially copyable (free functions, member functions, lvalue function objects)
+
+    // a function object is stored inline if it fits the storage and can be moved without throwing, otherwise it's stored on the heap
+    template <typename Type>
+    static constexpr bool StoredInline = sizeof(Type) <= sizeof(Storage) && alignof(Type) <= alignof(Storage) && std::is_nothrow_move_constructible<Type>::value;
 
-    using DestroyStorageFunction = void(*)(Delegate*);
-    using CopyStorageFunction = void(*)(const Delegate*, Delegate*);
-    using MoveStorageFunction = void(*)(Delegate*, Delegate*);
+    // bound instance (or null for free functions) if the delegate doesn't own its function object
+    void const *Target() const { return *reinterpret_cast<void* const*>(&mData); }
 
-    DestroyStorageFunction  mDestroyStorage = nullptr;
-    CopyStorageFunction mCopyStorage = nullptr;
-    MoveStorageFunction mMoveStorage = nullptr;
+    void CopyFrom(Delegate const &other);
+    void MoveFrom(Delegate &other);
+    void Reset();
 
-    /**** helper function templates for special member functions ****/
-    template <typename Type>
-    static void DestroyStorage(Delegate *delegate)
+    /**** stub installed in unbound delegates (invoking a delegate never tests if it's bound) ****/
+    static Ret UnboundStub(Storage /*void*/ *, Args...) noexcept(NoExcept)
     {
-        reinterpret_cast<Type&>(delegate->mData).~Type();
+#if DELEGATE_UNBOUND_POLICY == DELEGATE_UNBOUND_THROW
+        if constexpr (NoExcept)
+            std::terminate();   // a noexcept delegate can't throw
+        else
+            throw DelegateNotBoundException();
+#elif DELEGATE_UNBOUND_POLICY == DELEGATE_UNBOUND_ABORT
+        std::abort();
+#else
+        static_assert(!std::is_reference<Ret>::value, "an unbound delegate can't return a default reference");
+        return Ret();
+#endif
     }
 
     template <typename Type>
-    static void CopyStorage(const Delegate *src, Delegate *dst)
+    static StorageManager const *Manager()
     {
-        new(&dst->mData) Type(reinterpret_cast<const Type&>(src->mData));
+        static const StorageManager manager{ &DestroyStorage<Type>, &CopyStorage<Type>, &MoveStorage<Type>, std::is_trivially_copyable<Type>::value };
+
+        return &manager;
     }
 
     template <typename Type>
-    static void MoveStorage(Delegate *src, Delegate *dst)
+    static StorageManager const *HeapManager()
     {
-        new(&dst->mData) Type(std::move(reinterpret_cast<Type&>(src->mData)));
+        static const StorageManager manager{ &DestroyHeapStorage<Type>, &CopyHeapStorage<Type>, &MoveHeapStorage<Type>, true };    // only the pointer is stored inline
+
+        return &manager;
     }
-};
 
-template <typename Ret, typename... Args>
-Delegate<Ret(Args...)>::Delegate()
-{
-    new(&mData) std::nullptr_t(nullptr);
+    /**** helper function templates for special member functions (function object stored inline) ****/
+    template <typename Type>
+    static void DestroyStorage(Storage *data)
+    {
+        reinterpret_cast<Type*>(data)->~Type();
+    }
 
-    mFunction = nullptr;
-}
+    template <typename Type>
+    static void CopyStorage(const Storage *src, Storage *dst)
+    {
+        new(dst) Type(*reinterpret_cast<const Type*>(src));
+    }
 
-template <typename Ret, typename... Args>
-Delegate<Ret(Args...)>::Delegate(Delegate const &other)
-{
-    if (other.mStored)
+    template <typename Type>
+    static void MoveStorage(Storage *src, Storage *dst)
     {
-        other.mCopyStorage(&other, this);
+        new(dst) Type(std::move(*reinterpret_cast<Type*>(src)));
+    }
 
-        mDestroyStorage = other.mDestroyStorage;
-        mCopyStorage = other.mCopyStorage;
-        mMoveStorage = other.mMoveStorage;
+    /**** helper function templates for special member functions (function object stored on the heap) ****/
+    template <typename Type>
+    static void DestroyHeapStorage(Storage *data)
+    {
+        delete *reinterpret_cast<Type**>(data);
+    }
 
-        mStored = true;
+    template <typename Type>
+    static void CopyHeapStorage(const Storage *src, Storage *dst)
+    {
+        new(dst) Type*(new Type(**reinterpret_cast<Type* const*>(src)));
     }
-    else
-        mData = other.mData;
 
-    mFunction = other.mFunction;
-}
+    template <typename Type>
+    static void MoveHeapStorage(Storage *src, Storage *dst)
+    {
+        new(dst) Type*(*reinterpret_cast<Type**>(src));
+        *reinterpret_cast<Type**>(src) = nullptr;   // the moved-from delegate doesn't own the function object anymore
+    }
+};
 
-template <typename Ret, typename... Args>
-Delegate<Ret(Args...)>::Delegate(Delegate &&other)
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+Delegate<Ret(Args...) noexcept(NoExcept), InlineSize>::Delegate()
 {
-    if (other.mStored)
-    {
-        other.mMoveStorage(&other, this);
+    new(&mData) std::nullptr_t(nullptr);
 
-        mDestroyStorage = other.mDestroyStorage;
-        mCopyStorage = other.mCopyStorage;
-        mMoveStorage = other.mMoveStorage;
+    mFunction = &UnboundStub;
+}
 
-        mStored = true;
-    }
-    else
-        mData = other.mData;
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+Delegate<Ret(Args...) noexcept(NoExcept), InlineSize>::Delegate(Delegate const &other)
+{
+    CopyFrom(other);
+}
 
-    mFunction = other.mFunction;
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+Delegate<Ret(Args...) noexcept(NoExcept), InlineSize>::Delegate(Delegate &&other) noexcept
+{
+    MoveFrom(other);
 }
 
-template <typename Ret, typename... Args>
-Delegate<Ret(Args...)>::~Delegate()
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+Delegate<Ret(Args...) noexcept(NoExcept), InlineSize>::~Delegate()
 {
-    if (mStored)
-        mDestroyStorage(this);
+    Reset();
 }
 
-template <typename Ret, typename... Args>
-Delegate<Ret(Args...)> &Delegate<Ret(Args...)>::operator=(Delegate const &other)
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+Delegate<Ret(Args...) noexcept(NoExcept), InlineSize> &Delegate<Ret(Args...) noexcept(NoExcept), InlineSize>::operator=(Delegate const &other)
 {
     Delegate temp(other);
     Swap(temp);
@@ -179,8 +273,8 @@ Delegate<Ret(Args...)> &Delegate<Ret(Args...)>::operator=(Delegate const &other)
     return *this;
 }
 
-template <typename Ret, typename... Args>
-Delegate<Ret(Args...)> &Delegate<Ret(Args...)>::operator=(Delegate &&other)
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+Delegate<Ret(Args...) noexcept(NoExcept), InlineSize> &Delegate<Ret(Args...) noexcept(NoExcept), InlineSize>::operator=(Delegate &&other) noexcept
 {
     Delegate temp(std::move(other));
     Swap(temp);
@@ -188,25 +282,33 @@ Delegate<Ret(Args...)> &Delegate<Ret(Args...)>::operator=(Delegate &&other)
     return *this;
 }
 
-template <typename Ret, typename... Args>
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
 template <auto FreeFunction, typename>
-void Delegate<Ret(Args...)>::Bind()
+void Delegate<Ret(Args...) noexcept(NoExcept), InlineSize>::Bind()
 {
+    static_assert(!NoExcept || std::is_nothrow_invocable_r<Ret, decltype(FreeFunction), Args...>::value, "a noexcept delegate can only be bound to a noexcept callable");
+
+    Reset();
+
     new(&mData) std::nullptr_t(nullptr);
 
-    mFunction = +[](Storage /*void*/ *, Args... args) -> Ret
+    mFunction = +[](Storage /*void*/ *, Args... args) noexcept(NoExcept) -> Ret
             {
                 return FreeFunction(std::forward<Args>(args)...);
             };
 }
 
-template <typename Ret, typename... Args>
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
 template <auto MemberFunction, typename Type, typename>
-void Delegate<Ret(Args...)>::Bind(Type &instance)
+void Delegate<Ret(Args...) noexcept(NoExcept), InlineSize>::Bind(Type &instance)
 {
+    static_assert(!NoExcept || std::is_nothrow_invocable_r<Ret, decltype(MemberFunction), Type, Args...>::value, "a noexcept delegate can only be bound to a noexcept callable");
+
+    Reset();
+
     new(&mData) Type*(&instance);
 
-    mFunction = +[](Storage /*void*/ *data, Args... args) -> Ret
+    mFunction = +[](Storage /*void*/ *data, Args... args) noexcept(NoExcept) -> Ret
             {
                 //Storage *storage = static_cast<Storage*>(data);
                 //Type *instance = *reinterpret_cast<Type**>(storage);
@@ -215,17 +317,19 @@ void Delegate<Ret(Args...)>::Bind(Type &instance)
             };
 }
 
-template <typename Ret, typename... Args>
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
 template <typename Type>
-void Delegate<Ret(Args...)>::Bind(Type &&funObj)
+void Delegate<Ret(Args...) noexcept(NoExcept), InlineSize>::Bind(Type &&funObj)
 {  
-    static_assert(sizeof(Type) <= sizeof(void*));
+    static_assert(!NoExcept || std::is_nothrow_invocable_r<Ret, Type, Args...>::value, "a noexcept delegate can only be bound to a noexcept callable");
+
+    Reset();
     
     if constexpr (std::is_lvalue_reference<Type>::value)
     {
         new(&mData) std::remove_reference_t<Type>*(&funObj);
 
-        mFunction = +[](Storage /*void*/ *data, Args... args) -> Ret
+        mFunction = +[](Storage /*void*/ *data, Args... args) noexcept(NoExcept) -> Ret
             {
                 //Storage *storage = static_cast<Storage*>(data);
                 //std::remove_reference_t<Type> *instance = *reinterpret_cast<std::remove_reference_t<Type>**>(storage);
@@ -233,127 +337,1323 @@ void Delegate<Ret(Args...)>::Bind(Type &&funObj)
                 return std::invoke(*instance, std::forward<Args>(args)...);
             };  
     }
-    else
+    else if constexpr (StoredInline<std::remove_cv_t<Type>>)
     {
-        new(&mData) Type(std::move(funObj));
-        mDestroyStorage = &DestroyStorage<Type>;
-        mStored = true;
+        using FunObj = std::remove_cv_t<Type>;
 
-        mFunction = +[](Storage /*void*/ *data, Args... args) -> Ret
+        new(&mData) FunObj(std::move(funObj));
+        mManager = Manager<FunObj>();
+
+        mFunction = +[](Storage /*void*/ *data, Args... args) noexcept(NoExcept) -> Ret
             {
                 //Storage *storage = static_cast<Storage*>(data);
-                //std::remove_reference_t<Type> *instance = reinterpret_cast<std::remove_reference_t<Type>*>(storage);
-                std::remove_reference_t<Type> *instance = reinterpret_cast<std::remove_reference_t<Type>*>(data);
+                //FunObj *instance = reinterpret_cast<FunObj*>(storage);
+                FunObj *instance = reinterpret_cast<FunObj*>(data);
                 return std::invoke(*instance, std::forward<Args>(args)...);
             };  
-    } 
+    }
+    else    // function object too big for the inline storage: spill to the heap
+    {
+        using FunObj = std::remove_cv_t<Type>;
+
+        new(&mData) FunObj*(new FunObj(std::move(funObj)));
+        mManager = HeapManager<FunObj>();
+
+        mFunction = +[](Storage /*void*/ *data, Args... args) noexcept(NoExcept) -> Ret
+            {
+                FunObj *instance = *reinterpret_cast<FunObj**>(data);
+                return std::invoke(*instance, std::forward<Args>(args)...);
+            };
+    }
 }
 
-template <typename Ret, typename... Args>
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
 template <typename... FwdArgs>
-Ret Delegate<Ret(Args...)>::operator()(FwdArgs&&... args)
+Ret Delegate<Ret(Args...) noexcept(NoExcept), InlineSize>::operator()(FwdArgs&&... args) noexcept(NoExcept)
 {
-    if (!*this)
-        throw DelegateNotBoundException();
-
     return mFunction(&mData, std::forward<FwdArgs>(args)...);
 }
 
-template <typename Ret, typename... Args>
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
 template <typename... FwdArgs>
-Ret Delegate<Ret(Args...)>::Invoke(FwdArgs&&... args)
+Ret Delegate<Ret(Args...) noexcept(NoExcept), InlineSize>::Invoke(FwdArgs&&... args) noexcept(NoExcept)
 {
     return (*this)(std::forward<FwdArgs>(args)...);
 }
 
-template <typename Ret, typename... Args>
-void Delegate<Ret(Args...)>::Swap(Delegate &other)
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+void Delegate<Ret(Args...) noexcept(NoExcept), InlineSize>::Swap(Delegate &other)
+{
+    Delegate temp(std::move(other));
+
+    other.Reset();
+    other.MoveFrom(*this);
+
+    Reset();
+    MoveFrom(temp);
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+bool Delegate<Ret(Args...) noexcept(NoExcept), InlineSize>::operator==(Delegate const &other) const
 {
-    if (other.mStored)
-        other.mCopyStorage(&other, this);
+    if (mManager || other.mManager)
+        return this == &other;
+
+    return mFunction == other.mFunction && Target() == other.Target();
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+std::size_t Delegate<Ret(Args...) noexcept(NoExcept), InlineSize>::Hash() const
+{
+    std::size_t functionHash = std::hash<std::uintptr_t>()(reinterpret_cast<std::uintptr_t>(mFunction));
+    std::size_t targetHash = std::hash<void const*>()(mManager ? this : Target());
+
+    return functionHash ^ (targetHash + 0x9e3779b9 + (functionHash << 6) + (functionHash >> 2));
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+void Delegate<Ret(Args...) noexcept(NoExcept), InlineSize>::CopyFrom(Delegate const &other)
+{
+    if (other.mManager)
+        other.mManager->copy(&other.mData, &mData);
     else
-         mData = other.mData;
+        mData = other.mData;
 
-    Function tempFunction = mFunction;
+    mManager = other.mManager;
     mFunction = other.mFunction;
-    other.mFunction = tempFunction;
+}
 
-    bool tempStored = mStored;
-    mStored = other.mStored;
-    other.mStored = tempStored;
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+void Delegate<Ret(Args...) noexcept(NoExcept), InlineSize>::MoveFrom(Delegate &other)
+{
+    if (other.mManager)
+        other.mManager->move(&other.mData, &mData);
+    else
+        mData = other.mData;
 
-    DestroyStorageFunction tempDestroyFun = mDestroyStorage;
-    mDestroyStorage = other.mDestroyStorage;
-    other.mDestroyStorage = tempDestroyFun;
+    mManager = other.mManager;
+    mFunction = other.mFunction;
+}
 
-    CopyStorageFunction tempCopyFun = mCopyStorage;
-    mCopyStorage = other.mCopyStorage;
-    other.mCopyStorage = tempCopyFun;
-    
-    MoveStorageFunction tempMoveFun = mMoveStorage;
-    mMoveStorage = other.mMoveStorage;
-    other.mMoveStorage = tempMoveFun;
+// destroy the stored function object (if any) and leave the delegate unbound
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+void Delegate<Ret(Args...) noexcept(NoExcept), InlineSize>::Reset()
+{
+    if (mManager)
+        mManager->destroy(&mData);
+
+    new(&mData) std::nullptr_t(nullptr);
+    mFunction = &UnboundStub;
+
+    mManager = nullptr;
 }
 
-/**************** multicast delegate ****************/
-#include <vector>
+/**** hash specialization (for unordered containers) ****/
+namespace std
+{
+    template <typename Signature, std::size_t InlineSize>
+    struct hash<Delegate<Signature, InlineSize>>
+    {
+        std::size_t operator()(Delegate<Signature, InlineSize> const &delegate) const noexcept { return delegate.Hash(); }
+    };
+}
 
-/**** multicast delegate primary class template (not defined) ****/
-template <typename Signature>
-class MulticastDelegate;
+/**************** combiners ****************/
+// a combiner folds the results of the delegates called by an emission: it's called with each result and returns false
+// to stop the emission; combiners store their state by value, so combining results doesn't allocate
 
-/**** delegate partial class template for function types ****/
-template <typename Ret, typename... Args>
-class MulticastDelegate<Ret(Args...)>
+/**** sum of the results ****/
+template <typename Type>
+class SumCombiner
 {
 public:
-    MulticastDelegate(std::size_t size = 10U)  { mDelegates.reserve(size); }
-    
-    template <auto FreeFunction>
-    void Bind();
+    explicit SumCombiner(Type init = Type()) : mSum(init) {}
 
-    template <auto MemberFunction, typename Type>
-    void Bind(Type &instance);
+    bool operator()(Type const &result) { mSum += result; return true; }
 
-    template <typename Type>
-    void Bind(Type &&funObj);
+    Type const &Result() const { return mSum; }
+private:
+    Type mSum;
+};
 
-    explicit operator bool() const { return !mDelegates.empty(); }
+/**** smallest result ****/
+template <typename Type>
+class MinCombiner
+{
+public:
+    bool operator()(Type const &result) { if (mEmpty || result < mMin) mMin = result; mEmpty = false; return true; }
 
-    void operator()(Args... args) { for (auto &delegate : mDelegates) delegate(std::forward<Args>(args)...); }
-    void Invoke(Args... args) { for (auto &delegate : mDelegates) delegate.Invoke(std::forward<Args>(args)...); }
+    bool Empty() const { return mEmpty; }
+    Type const &Result() const { return mMin; }     // value-initialized if there were no results
 private:
-    std::vector<Delegate<Ret(Args...)>> mDelegates;
+    Type mMin = Type();
+    bool mEmpty = true;
 };
 
-template <typename Ret, typename... Args>
-template <auto FreeFunction>
-void MulticastDelegate<Ret(Args...)>::Bind()
+/**** largest result ****/
+template <typename Type>
+class MaxCombiner
+{
+public:
+    bool operator()(Type const &result) { if (mEmpty || mMax < result) mMax = result; mEmpty = false; return true; }
+
+    bool Empty() const { return mEmpty; }
+    Type const &Result() const { return mMax; }     // value-initialized if there were no results
+private:
+    Type mMax = Type();
+    bool mEmpty = true;
+};
+
+/**** first result different from a value-initialized one (stops the emission) ****/
+template <typename Type>
+class FirstNonDefaultCombiner
+{
+public:
+    bool operator()(Type const &result) { if (result == Type()) return true; mResult = result; return false; }
+
+    Type const &Result() const { return mResult; }
+private:
+    Type mResult = Type();
+};
+
+/**** results copied into a caller-provided buffer (stops the emission when the buffer is full) ****/
+template <typename Type>
+class CollectCombiner
+{
+public:
+    CollectCombiner(Type *buffer, std::size_t capacity) : mBuffer(buffer), mCapacity(capacity) {}
+
+    bool operator()(Type const &result) { if (mSize == mCapacity) return false; mBuffer[mSize++] = result; return mSize != mCapacity; }
+
+    std::size_t Size() const { return mSize; }
+private:
+    Type *mBuffer;
+    std::size_t mCapacity;
+    std::size_t mSize = 0;
+};
+
+/**** custom left fold (result = operation(result, delegate's result)) ****/
+template <typename Type, typename BinaryOperation>
+class FoldCombiner
+{
+public:
+    FoldCombiner(Type init, BinaryOperation operation) : mResult(std::move(init)), mOperation(std::move(operation)) {}
+
+    bool operator()(Type const &result) { mResult = mOperation(std::move(mResult), result); return true; }
+
+    Type const &Result() const { return mResult; }
+private:
+    Type mResult;
+    BinaryOperation mOperation;
+};
+
+template <typename Type, typename BinaryOperation>
+FoldCombiner<Type, std::decay_t<BinaryOperation>> MakeFoldCombiner(Type init, BinaryOperation &&operation)
+{
+    return FoldCombiner<Type, std::decay_t<BinaryOperation>>(std::move(init), std::forward<BinaryOperation>(operation));
+}
+
+/**************** delegate index ****************/
+// open addressing (linear probing) hash table from the function/target pair of a non-owning delegate to a position:
+// the entries are kept in a single array growing geometrically, so binding and unbinding don't allocate a node each
+template <typename Function>
+class DelegateIndex
+{
+public:
+    static constexpr std::uint32_t NoPosition = std::uint32_t(-1);
+
+    // position of the function/target pair (NoPosition if not indexed)
+    std::uint32_t Find(Function function, void const *target) const;
+
+    // returns false if the function/target pair is already indexed
+    bool Insert(Function function, void const *target, std::uint32_t position);
+
+    // returns false if the function/target pair is not indexed
+    bool Erase(Function function, void const *target);
+
+    // the indexed function/target pair is moving to a new position
+    void Update(Function function, void const *target, std::uint32_t position) { mEntries[FindEntry(function, target)].position = position; }
+
+    void Swap(DelegateIndex &other) { mEntries.swap(other.mEntries); std::swap(mSize, other.mSize); }
+
+    std::size_t Size() const { return mSize; }
+private:
+    struct Entry
+    {
+        Function function;      // null if the entry is empty
+        void const *target;
+        std::uint32_t position;
+    };
+
+    std::vector<Entry> mEntries;
+    std::size_t mSize = 0;
+
+    std::size_t Home(Function function, void const *target) const;
+    std::size_t Next(std::size_t entry) const { return (entry + 1) & (mEntries.size() - 1); }
+    std::size_t FindEntry(Function function, void const *target) const;
+    void Grow();
+};
+
+template <typename Function>
+constexpr std::uint32_t DelegateIndex<Function>::NoPosition;
+
+template <typename Function>
+std::size_t DelegateIndex<Function>::Home(Function function, void const *target) const
+{
+    std::size_t functionHash = std::hash<std::uintptr_t>()(reinterpret_cast<std::uintptr_t>(function));
+    std::size_t targetHash = std::hash<void const*>()(target);
+
+    return (functionHash ^ (targetHash + 0x9e3779b9 + (functionHash << 6) + (functionHash >> 2))) & (mEntries.size() - 1);
+}
+
+template <typename Function>
+std::size_t DelegateIndex<Function>::FindEntry(Function function, void const *target) const
+{
+    if (mEntries.empty())
+        return mEntries.size();
+
+    for (std::size_t entry = Home(function, target); mEntries[entry].function; entry = Next(entry))
+        if (mEntries[entry].function == function && mEntries[entry].target == target)
+            return entry;
+
+    return mEntries.size();
+}
+
+template <typename Function>
+std::uint32_t DelegateIndex<Function>::Find(Function function, void const *target) const
+{
+    std::size_t entry = FindEntry(function, target);
+
+    return entry == mEntries.size() ? NoPosition : mEntries[entry].position;
+}
+
+template <typename Function>
+bool DelegateIndex<Function>::Insert(Function function, void const *target, std::uint32_t position)
+{
+    if (FindEntry(function, target) != mEntries.size())
+        return false;
+
+    if (2 * (mSize + 1) > mEntries.size())     // keep the load factor under 1/2
+        Grow();
+
+    std::size_t entry = Home(function, target);
+
+    while (mEntries[entry].function)
+        entry = Next(entry);
+
+    mEntries[entry] = Entry{ function, target, position };
+    mSize++;
+
+    return true;
+}
+
+// backward shift deletion: the entries following the erased one are moved back if that brings them closer to their
+// home entry, so lookups never need tombstones
+template <typename Function>
+bool DelegateIndex<Function>::Erase(Function function, void const *target)
+{
+    std::size_t hole = FindEntry(function, target);
+
+    if (hole == mEntries.size())
+        return false;
+
+    for (std::size_t entry = Next(hole); mEntries[entry].function; entry = Next(entry))
+    {
+        std::size_t home = Home(mEntries[entry].function, mEntries[entry].target);
+
+        // move the entry unless its home lies cyclically in (hole, entry]
+        if ((hole < entry) ? (home <= hole || home > entry) : (home <= hole && home > entry))
+        {
+            mEntries[hole] = mEntries[entry];
+            hole = entry;
+        }
+    }
+
+    mEntries[hole].function = nullptr;
+    mSize--;
+
+    return true;
+}
+
+template <typename Function>
+void DelegateIndex<Function>::Grow()
 {
-    Delegate<Ret(Args...)> delegate;
-    mDelegates.push_back(delegate);
+    std::vector<Entry> entries(mEntries.empty() ? 16 : 2 * mEntries.size(), Entry{ nullptr, nullptr, 0 });
+    entries.swap(mEntries);
+
+    for (Entry const &old : entries)
+        if (old.function)
+        {
+            std::size_t entry = Home(old.function, old.target);
 
-    mDelegates.back().template Bind<FreeFunction>();
+            while (mEntries[entry].function)
+                entry = Next(entry);
+
+            mEntries[entry] = old;
+        }
 }
 
-template <typename Ret, typename... Args>
+/**************** member function batches ****************/
+
+/**** argument passed on to several delegates ****/
+// reference parameters are forwarded, parameters taken by value are passed as lvalues (so the delegates called later 
+// don't get moved-from values)
+template <typename Arg>
+using Relayed = std::conditional_t<std::is_reference_v<Arg>, Arg&&, Arg&>;
+
+/**** member function batches primary class template (not defined) ****/
+template <typename Signature, std::size_t InlineSize = DELEGATE_INLINE_SIZE>
+class MemberFunctionBatches;
+
+/**** member function batches partial class template for function types ****/
+// groups the instances bound to the same member function: each group is called by a single stub looping over the 
+// instances with the member function call inlined (one indirect call per group instead of one per instance)
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+class MemberFunctionBatches<Ret(Args...) noexcept(NoExcept), InlineSize>
+{
+public:
+    using DelegateType = Delegate<Ret(Args...) noexcept(NoExcept), InlineSize>;
+
+    // returns false if the instance is already bound to the member function
+    template <auto MemberFunction, typename Type>
+    bool Insert(Type &instance);
+
+    // returns false if the delegate is not in a batch
+    bool Remove(DelegateType const &delegate);
+
+    bool Contains(DelegateType const &delegate) const { return !delegate.mManager && mIndex.Find(delegate.mFunction, delegate.Target()) != DelegateIndex<Function>::NoPosition; }
+
+    void Swap(MemberFunctionBatches &other);
+
+    bool Empty() const { return mBatches.empty(); }
+
+    // number of instances in all batches
+    std::size_t Size() const { return mIndex.Size(); }
+
+    void operator()(Args... args) const noexcept(NoExcept) { for (auto &batch : mBatches) batch.function(batch.instances.data(), batch.instances.size(), static_cast<Relayed<Args>>(args)...); }
+
+    // calls the instances one at a time through the delegate stubs (batch stubs discard the results), 
+    // returns false if the combiner stopped the emission
+    template <typename Combiner>
+    bool Combine(Combiner &combiner, Args... args) const;
+
+    // calls the instances in [begin, end) (batches are numbered in order)
+    void operator()(std::size_t begin, std::size_t end, Args... args) const noexcept(NoExcept);
+private:
+    using Function = typename DelegateType::Function;
+    using Storage = typename DelegateType::Storage;
+    using BatchFunction = void(*)(void* const*, std::size_t, Args...) noexcept(NoExcept);
+
+    struct Batch
+    {
+        Function stub;                  // stub of the delegates in the batch
+        BatchFunction function;
+        std::vector<void*> instances;
+    };
+
+    std::vector<Batch> mBatches;
+    DelegateIndex<Function> mBatchIndex;    // position of the batch of each stub (with a null target)
+    DelegateIndex<Function> mIndex;         // position of each delegate's instance in its batch
+
+    template <auto MemberFunction, typename Type>
+    static void BatchStub(void* const *instances, std::size_t count, Args... args) noexcept(NoExcept)
+    {
+        for (std::size_t i = 0; i < count; i++)
+            std::invoke(MemberFunction, static_cast<Type*>(instances[i]), static_cast<Relayed<Args>>(args)...);
+    }
+};
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
 template <auto MemberFunction, typename Type>
-void MulticastDelegate<Ret(Args...)>::Bind(Type &instance)
+bool MemberFunctionBatches<Ret(Args...) noexcept(NoExcept), InlineSize>::Insert(Type &instance)
 {
-    Delegate<Ret(Args...)> delegate;
-    mDelegates.push_back(delegate);
+    DelegateType delegate;
+    delegate.template Bind<MemberFunction>(instance);
 
-    mDelegates.back().template Bind<MemberFunction>(instance);
+    std::uint32_t batch = mBatchIndex.Find(delegate.mFunction, nullptr);
+
+    if (batch == DelegateIndex<Function>::NoPosition)
+    {
+        mBatches.push_back(Batch{ delegate.mFunction, &BatchStub<MemberFunction, Type>, {} });
+        batch = std::uint32_t(mBatches.size() - 1);
+
+        try
+        {
+            mBatchIndex.Insert(delegate.mFunction, nullptr, batch);
+        }
+        catch (...)
+        {
+            mBatches.pop_back();
+            throw;
+        }
+    }
+
+    std::vector<void*> &instances = mBatches[batch].instances;
+
+    if (!mIndex.Insert(delegate.mFunction, delegate.Target(), std::uint32_t(instances.size())))     // already bound
+        return false;
+
+    try
+    {
+        instances.push_back(const_cast<void*>(static_cast<void const*>(&instance)));
+    }
+    catch (...)
+    {
+        mIndex.Erase(delegate.mFunction, delegate.Target());
+        throw;
+    }
+
+    return true;
 }
 
-template <typename Ret, typename... Args>
-template <typename Type>
-void MulticastDelegate<Ret(Args...)>::Bind(Type &&funObj)
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+bool MemberFunctionBatches<Ret(Args...) noexcept(NoExcept), InlineSize>::Remove(DelegateType const &delegate)
+{
+    std::uint32_t index = delegate.mManager ? DelegateIndex<Function>::NoPosition : mIndex.Find(delegate.mFunction, delegate.Target());
+
+    if (index == DelegateIndex<Function>::NoPosition)
+        return false;
+
+    mIndex.Erase(delegate.mFunction, delegate.Target());
+
+    std::uint32_t batchIndex = mBatchIndex.Find(delegate.mFunction, nullptr);
+    std::vector<void*> &instances = mBatches[batchIndex].instances;
+
+    // move the last instance in place of the removed one
+    if (index != instances.size() - 1)
+    {
+        instances[index] = instances.back();
+        mIndex.Update(delegate.mFunction, instances[index], index);
+    }
+
+    instances.pop_back();
+
+    // remove empty batches (moving the last batch in place of the removed one)
+    if (instances.empty())
+    {
+        mBatchIndex.Erase(delegate.mFunction, nullptr);
+
+        if (batchIndex != mBatches.size() - 1)
+        {
+            mBatches[batchIndex] = std::move(mBatches.back());
+            mBatchIndex.Update(mBatches[batchIndex].stub, nullptr, batchIndex);
+        }
+
+        mBatches.pop_back();
+    }
+
+    return true;
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+void MemberFunctionBatches<Ret(Args...) noexcept(NoExcept), InlineSize>::Swap(MemberFunctionBatches &other)
 {
-    Delegate<Ret(Args...)> delegate;
-    mDelegates.push_back(delegate);
+    mBatches.swap(other.mBatches);
+    mBatchIndex.Swap(other.mBatchIndex);
+    mIndex.Swap(other.mIndex);
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+template <typename Combiner>
+bool MemberFunctionBatches<Ret(Args...) noexcept(NoExcept), InlineSize>::Combine(Combiner &combiner, Args... args) const
+{
+    Storage data;
+
+    for (auto &batch : mBatches)
+        for (void *instance : batch.instances)
+        {
+            new(&data) void*(instance);
+
+            if (!combiner(batch.stub(&data, static_cast<Relayed<Args>>(args)...)))
+                return false;
+        }
+
+    return true;
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+void MemberFunctionBatches<Ret(Args...) noexcept(NoExcept), InlineSize>::operator()(std::size_t begin, std::size_t end, Args... args) const noexcept(NoExcept)
+{
+    for (auto &batch : mBatches)
+    {
+        std::size_t size = batch.instances.size();
+
+        if (begin < size && begin < end)
+            batch.function(batch.instances.data() + begin, std::min(end, size) - begin, static_cast<Relayed<Args>>(args)...);
+
+        begin = begin > size ? begin - size : 0;
+        end = end > size ? end - size : 0;
+
+        if (end == 0)
+            break;
+    }
+}
+
+/**************** multicast delegate ****************/
+
+/**** multicast delegate primary class template (not defined) ****/
+template <typename Signature, std::size_t InlineSize = DELEGATE_INLINE_SIZE>
+class MulticastDelegate;
+
+/**** namespace scope swap function ****/
+template <typename Signature, std::size_t InlineSize>
+void swap(MulticastDelegate<Signature, InlineSize> &md1, MulticastDelegate<Signature, InlineSize> &md2)
+{   
+    md1.Swap(md2);
+}
+
+/**** delegate partial class template for function types ****/
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+class MulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>
+{
+public:
+    using DelegateType = Delegate<Ret(Args...) noexcept(NoExcept), InlineSize>;
+
+    MulticastDelegate(std::size_t size = 10U)  { Reserve(size); }
+
+    MulticastDelegate(MulticastDelegate const &other);
+
+    MulticastDelegate(MulticastDelegate &&other);
+
+    ~MulticastDelegate();
+
+    MulticastDelegate &operator=(MulticastDelegate const &other);
+
+    MulticastDelegate &operator=(MulticastDelegate &&other);
+    
+    // binding a function/instance pair that's already bound fails and returns false
+    template <auto FreeFunction>
+    bool Bind();
+
+    template <auto MemberFunction, typename Type>
+    bool Bind(Type &instance);
+
+    template <typename Type>
+    bool Bind(Type &&funObj);
+
+    // opts in to batching: the instances bound to the same member function are called together (one indirect call per 
+    // member function), before the delegates bound with Bind
+    template <auto MemberFunction, typename Type>
+    bool BindBatched(Type &instance);
+
+    // unbinding is O(1) (the last delegate is moved in place of the unbound one, so the call order changes);
+    // function objects bound as rvalues are owned by the multicast delegate and can't be unbound
+    template <auto FreeFunction>
+    bool Unbind();
+
+    template <auto MemberFunction, typename Type>
+    bool Unbind(Type &instance);
+
+    template <typename Type, typename = std::enable_if_t<!std::is_same<std::remove_cv_t<Type>, DelegateType>::value>>
+    bool Unbind(Type &funObj);
+
+    bool Unbind(DelegateType const &delegate);
+
+    void Swap(MulticastDelegate &other);
+
+    void Reserve(std::size_t capacity);
+
+    explicit operator bool() const { return mSize != 0 || !mBatches.Empty(); }
+
+    // instances bound with BindBatched are called first, batch by batch, then the other delegates (in binding order until 
+    // one is unbound)
+    void operator()(Args... args) noexcept(NoExcept) { mBatches(static_cast<Relayed<Args>>(args)...); for (std::size_t i = 0; i < mSize; i++) mDelegates[i](static_cast<Relayed<Args>>(args)...); }
+    void Invoke(Args... args) noexcept(NoExcept) { mBatches(static_cast<Relayed<Args>>(args)...); for (std::size_t i = 0; i < mSize; i++) mDelegates[i].Invoke(static_cast<Relayed<Args>>(args)...); }
+
+    // calls the delegates passing each result to the combiner (until the combiner returns false), returns the combiner
+    template <typename Combiner>
+    Combiner Combine(Combiner combiner, Args... args);
+
+    // calls the delegates on the thread pool's threads (in no particular order), returns when all have returned; 
+    // the delegates must be safe to call concurrently and mustn't bind to or unbind from the multicast delegate
+    void InvokeParallel(Args... args) { InvokeParallel(ThreadPool::Instance(), std::forward<Args>(args)...); }
+    void InvokeParallel(ThreadPool &pool, Args... args);
+private:
+    using Function = typename DelegateType::Function;
+
+    // delegates are kept in a manually grown buffer so that trivially relocatable ones are moved with memcpy when it grows
+    DelegateType *mDelegates = nullptr;
+    std::size_t mSize = 0;
+    std::size_t mCapacity = 0;
+    std::size_t mNonRelocatable = 0;    // number of delegates that must be moved with their move constructor
+
+    DelegateIndex<Function> mIndex;     // position of each delegate not owning its function object
+
+    MemberFunctionBatches<Ret(Args...) noexcept(NoExcept), InlineSize> mBatches;    // delegates bound with BindBatched
+
+    bool PushBack(DelegateType &&delegate);
+    void Remove(std::size_t index);
+};
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+MulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::MulticastDelegate(MulticastDelegate const &other) : mBatches(other.mBatches)
+{
+    Reserve(other.mSize);
+
+    for (std::size_t i = 0; i < other.mSize; i++)
+        PushBack(DelegateType(other.mDelegates[i]));
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+MulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::MulticastDelegate(MulticastDelegate &&other)
+{
+    Swap(other);
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+MulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::~MulticastDelegate()
+{
+    for (std::size_t i = 0; i < mSize; i++)
+        mDelegates[i].~DelegateType();
+
+    ::operator delete(mDelegates);
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+MulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize> &MulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::operator=(MulticastDelegate const &other)
+{
+    MulticastDelegate temp(other);
+    Swap(temp);
+
+    return *this;
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+MulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize> &MulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::operator=(MulticastDelegate &&other)
+{
+    MulticastDelegate temp(std::move(other));
+    Swap(temp);
+
+    return *this;
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+template <auto FreeFunction>
+bool MulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::Bind()
+{
+    DelegateType delegate;
+    delegate.template Bind<FreeFunction>();
+
+    return PushBack(std::move(delegate));
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+template <auto MemberFunction, typename Type>
+bool MulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::Bind(Type &instance)
+{
+    DelegateType delegate;
+    delegate.template Bind<MemberFunction>(instance);
+
+    if (mBatches.Contains(delegate))    // already bound with BindBatched
+        return false;
+
+    return PushBack(std::move(delegate));
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+template <auto MemberFunction, typename Type>
+bool MulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::BindBatched(Type &instance)
+{
+    DelegateType delegate;
+    delegate.template Bind<MemberFunction>(instance);
+
+    if (mIndex.Find(delegate.mFunction, delegate.Target()) != DelegateIndex<Function>::NoPosition)     // already bound with Bind
+        return false;
+
+    return mBatches.template Insert<MemberFunction>(instance);
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+template <typename Type>
+bool MulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::Bind(Type &&funObj)
+{
+    DelegateType delegate;
+    delegate.Bind(std::forward<Type>(funObj));
+
+    return PushBack(std::move(delegate));
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+template <auto FreeFunction>
+bool MulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::Unbind()
+{
+    DelegateType delegate;
+    delegate.template Bind<FreeFunction>();
+
+    return Unbind(delegate);
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+template <auto MemberFunction, typename Type>
+bool MulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::Unbind(Type &instance)
+{
+    DelegateType delegate;
+    delegate.template Bind<MemberFunction>(instance);
+
+    return Unbind(delegate);
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+template <typename Type, typename>
+bool MulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::Unbind(Type &funObj)
+{
+    DelegateType delegate;
+    delegate.Bind(funObj);
+
+    return Unbind(delegate);
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+bool MulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::Unbind(DelegateType const &delegate)
+{
+    if (mBatches.Remove(delegate))
+        return true;
+
+    std::uint32_t index = delegate.mManager ? DelegateIndex<Function>::NoPosition : mIndex.Find(delegate.mFunction, delegate.Target());
+
+    if (index == DelegateIndex<Function>::NoPosition)
+        return false;
+
+    mIndex.Erase(delegate.mFunction, delegate.Target());
+
+    Remove(index);
+
+    return true;
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+void MulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::Swap(MulticastDelegate &other)
+{
+    std::swap(mDelegates, other.mDelegates);
+    std::swap(mSize, other.mSize);
+    std::swap(mCapacity, other.mCapacity);
+    std::swap(mNonRelocatable, other.mNonRelocatable);
+
+    mIndex.Swap(other.mIndex);
+
+    mBatches.Swap(other.mBatches);
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+void MulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::Reserve(std::size_t capacity)
+{
+    if (capacity <= mCapacity)
+        return;
+
+    DelegateType *delegates = static_cast<DelegateType*>(::operator new(capacity * sizeof(DelegateType)));
+
+    if (mNonRelocatable == 0 && mSize != 0)    // relocate the whole buffer at once
+        std::memcpy(static_cast<void*>(delegates), static_cast<void*>(mDelegates), mSize * sizeof(DelegateType));
+    else
+        for (std::size_t i = 0; i < mSize; i++)
+            if (mDelegates[i].IsTriviallyRelocatable())
+                std::memcpy(static_cast<void*>(delegates + i), static_cast<void*>(mDelegates + i), sizeof(DelegateType));
+            else
+            {
+                new(delegates + i) DelegateType(std::move(mDelegates[i]));
+                mDelegates[i].~DelegateType();
+            }
+
+    ::operator delete(mDelegates);   // relocated delegates are not destroyed
+
+    mDelegates = delegates;
+    mCapacity = capacity;
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+bool MulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::PushBack(DelegateType &&delegate)
+{
+    if (mSize == mCapacity)
+        Reserve(mCapacity ? 2 * mCapacity : 1);
+
+    if (!delegate.mManager && !mIndex.Insert(delegate.mFunction, delegate.Target(), std::uint32_t(mSize)))     // already bound
+        return false;
+
+    new(mDelegates + mSize) DelegateType(std::move(delegate));
+
+    if (!mDelegates[mSize].IsTriviallyRelocatable())
+        mNonRelocatable++;
+
+    mSize++;
+
+    return true;
+}
+
+// move the last delegate in place of the removed one (its index entry, if any, must have been erased already)
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+void MulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::Remove(std::size_t index)
+{
+    if (!mDelegates[index].IsTriviallyRelocatable())
+        mNonRelocatable--;
+
+    std::size_t last = mSize - 1;
+
+    if (index != last)
+    {
+        mDelegates[index] = std::move(mDelegates[last]);
+
+        if (!mDelegates[index].mManager)
+            mIndex.Update(mDelegates[index].mFunction, mDelegates[index].Target(), std::uint32_t(index));
+    }
+
+    mDelegates[last].~DelegateType();
+    mSize--;
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+template <typename Combiner>
+Combiner MulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::Combine(Combiner combiner, Args... args)
+{
+    static_assert(!std::is_void_v<Ret>, "the results of void delegates can't be combined");
+
+    if (!mBatches.Combine(combiner, static_cast<Relayed<Args>>(args)...))
+        return combiner;
+
+    for (std::size_t i = 0; i < mSize; i++)
+        if (!combiner(mDelegates[i](static_cast<Relayed<Args>>(args)...)))
+            break;
+
+    return combiner;
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+void MulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::InvokeParallel(ThreadPool &pool, Args... args)
+{
+    std::size_t batched = mBatches.Size();
+
+    // batched instances first, then the other delegates
+    pool.ParallelFor(batched + mSize, THREAD_POOL_GRAIN, [&](std::size_t begin, std::size_t end)
+    {
+        if (begin < batched)
+            mBatches(begin, std::min(end, batched), static_cast<Relayed<Args>>(args)...);
+
+        for (std::size_t i = std::max(begin, batched); i < end; i++)
+            mDelegates[i - batched](static_cast<Relayed<Args>>(args)...);
+    });
+}
+
+/**************** packed multicast delegate ****************/
+
+/***** prefetching (emission prefetches the instances bound to the delegates a few positions ahead) *****/
+#if defined(__GNUC__) || defined(__clang__)
+#define DELEGATE_PREFETCH(address) __builtin_prefetch(address)
+#else
+#define DELEGATE_PREFETCH(address) ((void)(address))
+#endif
+
+#ifndef DELEGATE_PREFETCH_DISTANCE
+#define DELEGATE_PREFETCH_DISTANCE 8
+#endif
+
+/**** packed multicast delegate primary class template (not defined) ****/
+template <typename Signature, std::size_t InlineSize = DELEGATE_INLINE_SIZE>
+class PackedMulticastDelegate;
+
+/**** namespace scope swap function ****/
+template <typename Signature, std::size_t InlineSize>
+void swap(PackedMulticastDelegate<Signature, InlineSize> &md1, PackedMulticastDelegate<Signature, InlineSize> &md2)
+{   
+    md1.Swap(md2);
+}
+
+/**** packed multicast delegate partial class template for function types ****/
+// structure of arrays layout: stub pointers and stored data are kept in two separate packed arrays and the storage managers 
+// (only needed when binding, unbinding, copying and growing) in a third one, so that emission touches only the hot data
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+class PackedMulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>
+{
+public:
+    using DelegateType = Delegate<Ret(Args...) noexcept(NoExcept), InlineSize>;
+
+    PackedMulticastDelegate(std::size_t size = 10U)  { Reserve(size); }
+
+    PackedMulticastDelegate(PackedMulticastDelegate const &other);
+
+    PackedMulticastDelegate(PackedMulticastDelegate &&other);
+
+    ~PackedMulticastDelegate();
+
+    PackedMulticastDelegate &operator=(PackedMulticastDelegate const &other);
+
+    PackedMulticastDelegate &operator=(PackedMulticastDelegate &&other);
+
+    // binding a function/instance pair that's already bound fails and returns false
+    template <auto FreeFunction>
+    bool Bind();
+
+    template <auto MemberFunction, typename Type>
+    bool Bind(Type &instance);
+
+    template <typename Type>
+    bool Bind(Type &&funObj);
+
+    // opts in to batching: the instances bound to the same member function are called together (one indirect call per 
+    // member function), before the delegates bound with Bind
+    template <auto MemberFunction, typename Type>
+    bool BindBatched(Type &instance);
+
+    // unbinding is O(1) (the last delegate is moved in place of the unbound one, so the call order changes);
+    // function objects bound as rvalues are owned by the multicast delegate and can't be unbound
+    template <auto FreeFunction>
+    bool Unbind();
+
+    template <auto MemberFunction, typename Type>
+    bool Unbind(Type &instance);
+
+    template <typename Type, typename = std::enable_if_t<!std::is_same<std::remove_cv_t<Type>, DelegateType>::value>>
+    bool Unbind(Type &funObj);
+
+    bool Unbind(DelegateType const &delegate);
+
+    void Swap(PackedMulticastDelegate &other);
+
+    void Reserve(std::size_t capacity);
+
+    explicit operator bool() const { return mSize != 0 || !mBatches.Empty(); }
+
+    // instances bound with BindBatched are called first, batch by batch, then the other delegates (in binding order until 
+    // one is unbound)
+    void operator()(Args... args) noexcept(NoExcept);
+    void Invoke(Args... args) noexcept(NoExcept) { (*this)(std::forward<Args>(args)...); }
+
+    // calls the delegates passing each result to the combiner (until the combiner returns false), returns the combiner
+    template <typename Combiner>
+    Combiner Combine(Combiner combiner, Args... args);
+
+    // calls the delegates on the thread pool's threads (in no particular order), returns when all have returned; 
+    // the delegates must be safe to call concurrently and mustn't bind to or unbind from the multicast delegate
+    void InvokeParallel(Args... args) { InvokeParallel(ThreadPool::Instance(), std::forward<Args>(args)...); }
+    void InvokeParallel(ThreadPool &pool, Args... args);
+private:
+    using Storage = typename DelegateType::Storage;
+    using Function = typename DelegateType::Function;
+    using StorageManager = typename DelegateType::StorageManager;
+
+    Function *mFunctions = nullptr;                 // hot
+    Storage *mData = nullptr;                       // hot
+    StorageManager const **mManagers = nullptr;     // cold
+    std::size_t mSize = 0;
+    std::size_t mCapacity = 0;
+    std::size_t mNonRelocatable = 0;                // number of stored function objects that must be moved with their move constructor
+
+    DelegateIndex<Function> mIndex;     // position of each delegate not owning its function object
+
+    MemberFunctionBatches<Ret(Args...) noexcept(NoExcept), InlineSize> mBatches;    // delegates bound with BindBatched
+
+    bool PushBack(DelegateType &&delegate);
+    void Remove(std::size_t index);
+};
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+PackedMulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::PackedMulticastDelegate(PackedMulticastDelegate const &other) : mIndex(other.mIndex), mBatches(other.mBatches)
+{
+    Reserve(other.mSize);
+
+    for (std::size_t i = 0; i < other.mSize; i++)
+    {
+        if (other.mManagers[i])
+            other.mManagers[i]->copy(other.mData + i, mData + i);
+        else
+            mData[i] = other.mData[i];
+
+        mFunctions[i] = other.mFunctions[i];
+        mManagers[i] = other.mManagers[i];
+
+        mSize++;
+    }
+
+    mNonRelocatable = other.mNonRelocatable;
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+PackedMulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::PackedMulticastDelegate(PackedMulticastDelegate &&other)
+{
+    Swap(other);
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+PackedMulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::~PackedMulticastDelegate()
+{
+    for (std::size_t i = 0; i < mSize; i++)
+        if (mManagers[i])
+            mManagers[i]->destroy(mData + i);
+
+    delete[] mFunctions;
+    delete[] mData;
+    delete[] mManagers;
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+PackedMulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize> &PackedMulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::operator=(PackedMulticastDelegate const &other)
+{
+    PackedMulticastDelegate temp(other);
+    Swap(temp);
+
+    return *this;
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+PackedMulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize> &PackedMulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::operator=(PackedMulticastDelegate &&other)
+{
+    PackedMulticastDelegate temp(std::move(other));
+    Swap(temp);
+
+    return *this;
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+template <auto FreeFunction>
+bool PackedMulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::Bind()
+{
+    DelegateType delegate;
+    delegate.template Bind<FreeFunction>();
+
+    return PushBack(std::move(delegate));
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+template <auto MemberFunction, typename Type>
+bool PackedMulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::Bind(Type &instance)
+{
+    DelegateType delegate;
+    delegate.template Bind<MemberFunction>(instance);
+
+    if (mBatches.Contains(delegate))    // already bound with BindBatched
+        return false;
+
+    return PushBack(std::move(delegate));
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+template <auto MemberFunction, typename Type>
+bool PackedMulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::BindBatched(Type &instance)
+{
+    DelegateType delegate;
+    delegate.template Bind<MemberFunction>(instance);
+
+    if (mIndex.Find(delegate.mFunction, delegate.Target()) != DelegateIndex<Function>::NoPosition)     // already bound with Bind
+        return false;
+
+    return mBatches.template Insert<MemberFunction>(instance);
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+template <typename Type>
+bool PackedMulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::Bind(Type &&funObj)
+{
+    DelegateType delegate;
+    delegate.Bind(std::forward<Type>(funObj));
+
+    return PushBack(std::move(delegate));
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+template <auto FreeFunction>
+bool PackedMulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::Unbind()
+{
+    DelegateType delegate;
+    delegate.template Bind<FreeFunction>();
+
+    return Unbind(delegate);
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+template <auto MemberFunction, typename Type>
+bool PackedMulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::Unbind(Type &instance)
+{
+    DelegateType delegate;
+    delegate.template Bind<MemberFunction>(instance);
+
+    return Unbind(delegate);
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+template <typename Type, typename>
+bool PackedMulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::Unbind(Type &funObj)
+{
+    DelegateType delegate;
+    delegate.Bind(funObj);
+
+    return Unbind(delegate);
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+bool PackedMulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::Unbind(DelegateType const &delegate)
+{
+    if (mBatches.Remove(delegate))
+        return true;
+
+    std::uint32_t index = delegate.mManager ? DelegateIndex<Function>::NoPosition : mIndex.Find(delegate.mFunction, delegate.Target());
+
+    if (index == DelegateIndex<Function>::NoPosition)
+        return false;
+
+    mIndex.Erase(delegate.mFunction, delegate.Target());
+
+    Remove(index);
+
+    return true;
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+void PackedMulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::Swap(PackedMulticastDelegate &other)
+{
+    std::swap(mFunctions, other.mFunctions);
+    std::swap(mData, other.mData);
+    std::swap(mManagers, other.mManagers);
+    std::swap(mSize, other.mSize);
+    std::swap(mCapacity, other.mCapacity);
+    std::swap(mNonRelocatable, other.mNonRelocatable);
+
+    mIndex.Swap(other.mIndex);
+
+    mBatches.Swap(other.mBatches);
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+void PackedMulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::Reserve(std::size_t capacity)
+{
+    if (capacity <= mCapacity)
+        return;
+
+    std::unique_ptr<Function[]> functions(new Function[capacity]);
+    std::unique_ptr<Storage[]> data(new Storage[capacity]);
+    std::unique_ptr<StorageManager const*[]> managers(new StorageManager const*[capacity]);
+
+    if (mSize != 0)
+    {
+        std::memcpy(functions.get(), mFunctions, mSize * sizeof(Function));
+        std::memcpy(managers.get(), mManagers, mSize * sizeof(StorageManager const*));
+
+        if (mNonRelocatable == 0)    // relocate all the stored data at once
+            std::memcpy(data.get(), mData, mSize * sizeof(Storage));
+        else
+            for (std::size_t i = 0; i < mSize; i++)
+                if (!mManagers[i] || mManagers[i]->relocatable)
+                    data[i] = mData[i];
+                else
+                {
+                    mManagers[i]->move(mData + i, data.get() + i);
+                    mManagers[i]->destroy(mData + i);
+                }
+    }
+
+    delete[] mFunctions;
+    delete[] mData;
+    delete[] mManagers;
+
+    mFunctions = functions.release();
+    mData = data.release();
+    mManagers = managers.release();
+    mCapacity = capacity;
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+void PackedMulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::operator()(Args... args) noexcept(NoExcept)
+{
+    mBatches(static_cast<Relayed<Args>>(args)...);
+
+    std::size_t i = 0;
+
+    for (; i + DELEGATE_PREFETCH_DISTANCE < mSize; i++)
+    {
+        DELEGATE_PREFETCH(*reinterpret_cast<void* const*>(mData + i + DELEGATE_PREFETCH_DISTANCE));   // bound instance (prefetching an invalid address is harmless)
+        mFunctions[i](mData + i, static_cast<Relayed<Args>>(args)...);
+    }
+
+    for (; i < mSize; i++)
+        mFunctions[i](mData + i, static_cast<Relayed<Args>>(args)...);
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+bool PackedMulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::PushBack(DelegateType &&delegate)
+{
+    if (mSize == mCapacity)
+        Reserve(mCapacity ? 2 * mCapacity : 1);
+
+    if (!delegate.mManager && !mIndex.Insert(delegate.mFunction, delegate.Target(), std::uint32_t(mSize)))     // already bound
+        return false;
+
+    if (delegate.mManager)
+        delegate.mManager->move(&delegate.mData, mData + mSize);    // the moved-from function object is destroyed with the delegate
+    else
+        mData[mSize] = delegate.mData;
+
+    mFunctions[mSize] = delegate.mFunction;
+    mManagers[mSize] = delegate.mManager;
+
+    if (!delegate.IsTriviallyRelocatable())
+        mNonRelocatable++;
+
+    mSize++;
+
+    return true;
+}
+
+// move the last delegate in place of the removed one (its index entry, if any, must have been erased already)
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+void PackedMulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::Remove(std::size_t index)
+{
+    if (mManagers[index])
+    {
+        if (!mManagers[index]->relocatable)
+            mNonRelocatable--;
+
+        mManagers[index]->destroy(mData + index);
+    }
+
+    std::size_t last = mSize - 1;
+
+    if (index != last)
+    {
+        if (mManagers[last])
+        {
+            mManagers[last]->move(mData + last, mData + index);
+            mManagers[last]->destroy(mData + last);
+        }
+        else
+            mData[index] = mData[last];
+
+        mFunctions[index] = mFunctions[last];
+        mManagers[index] = mManagers[last];
+
+        if (!mManagers[index])
+            mIndex.Update(mFunctions[index], *reinterpret_cast<void* const*>(mData + index), std::uint32_t(index));
+    }
+
+    mSize--;
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+template <typename Combiner>
+Combiner PackedMulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::Combine(Combiner combiner, Args... args)
+{
+    static_assert(!std::is_void_v<Ret>, "the results of void delegates can't be combined");
+
+    if (!mBatches.Combine(combiner, static_cast<Relayed<Args>>(args)...))
+        return combiner;
+
+    for (std::size_t i = 0; i < mSize; i++)
+        if (!combiner(mFunctions[i](mData + i, static_cast<Relayed<Args>>(args)...)))
+            break;
+
+    return combiner;
+}
+
+template <typename Ret, typename... Args, bool NoExcept, std::size_t InlineSize>
+void PackedMulticastDelegate<Ret(Args...) noexcept(NoExcept), InlineSize>::InvokeParallel(ThreadPool &pool, Args... args)
+{
+    std::size_t batched = mBatches.Size();
+
+    // batched instances first, then the other delegates
+    pool.ParallelFor(batched + mSize, THREAD_POOL_GRAIN, [&](std::size_t begin, std::size_t end)
+    {
+        if (begin < batched)
+            mBatches(begin, std::min(end, batched), static_cast<Relayed<Args>>(args)...);
 
-    mDelegates.back().Bind(std::forward<Type>(funObj));
+        for (std::size_t i = std::max(begin, batched); i < end; i++)
+            mFunctions[i - batched](mData + i - batched, static_cast<Relayed<Args>>(args)...);
+    });
 }
 
 #endif  // DELEGATE_H
\ No newline at end of file
@@ -0,0 +1,236 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+
+/***** default number of delegates per task of a parallel emission *****/
+#ifndef THREAD_POOL_GRAIN
+#define THREAD_POOL_GRAIN 64
+#endif
+
+/**************** thread pool ****************/
+// work stealing pool used by parallel emission: every worker owns a deque of tasks, it pops tasks from the back of its own
+// deque and, when that's empty, steals from the front of the other workers' deques; the thread waiting for a parallel loop
+// steals tasks too, so parallel loops can be nested (a delegate can emit in parallel from a worker)
+class ThreadPool
+{
+public:
+    // pool with a worker per hardware thread besides the calling one
+    explicit ThreadPool(std::size_t workers = std::max(1u, std::thread::hardware_concurrency()) - 1);
+
+    ThreadPool(ThreadPool const&) = delete;
+
+    ~ThreadPool();
+
+    ThreadPool &operator=(ThreadPool const&) = delete;
+
+    // pool shared by all the parallel emissions
+    static ThreadPool &Instance() { static ThreadPool pool; return pool; }
+
+    std::size_t Workers() const { return mWorkers.size(); }
+
+    // calls body(begin, end) on consecutive ranges of [0, count) of about grain indices, returns when all the calls have
+    // returned (rethrowing the first exception thrown by a call)
+    template <typename Body>
+    void ParallelFor(std::size_t count, std::size_t grain, Body &&body);
+private:
+    struct Loop
+    {
+        void (*run)(void *body, std::size_t begin, std::size_t end);
+        void *body;
+        std::atomic<std::size_t> pending;       // tasks not completed yet
+        std::mutex exceptionMutex;
+        std::exception_ptr exception;
+    };
+
+    struct Task
+    {
+        Loop *loop;
+        std::size_t begin;
+        std::size_t end;
+    };
+
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> mWorkers;
+    std::vector<std::thread> mThreads;
+
+    std::mutex mMutex;                  // guards sleeping (tasks are guarded by their worker's mutex)
+    std::condition_variable mWakeUp;
+    std::atomic<std::size_t> mQueued{ 0 };  // tasks in the deques
+    bool mStop = false;
+
+    void Work(std::size_t index);
+    bool Pop(std::size_t index, Task &task);
+    bool Steal(std::size_t thief, Task &task);
+    static void Run(Task const &task);
+};
+
+inline ThreadPool::ThreadPool(std::size_t workers)
+{
+    for (std::size_t i = 0; i < workers; i++)
+        mWorkers.push_back(std::make_unique<Worker>());
+
+    for (std::size_t i = 0; i < workers; i++)
+        mThreads.emplace_back(&ThreadPool::Work, this, i);
+}
+
+inline ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+
+    mWakeUp.notify_all();
+
+    for (auto &thread : mThreads)
+        thread.join();
+}
+
+template <typename Body>
+void ThreadPool::ParallelFor(std::size_t count, std::size_t grain, Body &&body)
+{
+    using BodyType = std::remove_reference_t<Body>;
+
+    if (count == 0)
+        return;
+
+    grain = std::max<std::size_t>(grain, 1);
+
+    std::size_t tasks = std::min((count + grain - 1) / grain, 4 * (mWorkers.size() + 1));
+
+    if (tasks <= 1 || mWorkers.empty())
+    {
+        body(std::size_t(0), count);
+
+        return;
+    }
+
+    Loop loop;
+    loop.run = [](void *body, std::size_t begin, std::size_t end) { (*static_cast<BodyType*>(body))(begin, end); };
+    loop.body = const_cast<void*>(static_cast<void const*>(std::addressof(body)));
+    loop.pending.store(tasks, std::memory_order_relaxed);
+
+    // deal the tasks to the workers round robin (counting them first, so the count never underflows when they're popped)
+    mQueued.fetch_add(tasks, std::memory_order_release);
+
+    for (std::size_t i = 0; i < tasks; i++)
+    {
+        Worker &worker = *mWorkers[i % mWorkers.size()];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+
+        worker.tasks.push_back(Task{ &loop, count * i / tasks, count * (i + 1) / tasks });
+    }
+
+    // synchronize with the workers going to sleep so the notification isn't lost
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+    }
+
+    mWakeUp.notify_all();
+
+    // help until all the tasks of the loop have completed
+    Task task;
+
+    while (loop.pending.load(std::memory_order_acquire) != 0)
+        if (Steal(mWorkers.size(), task))
+            Run(task);
+        else
+            std::this_thread::yield();
+
+    if (loop.exception)
+        std::rethrow_exception(loop.exception);
+}
+
+inline void ThreadPool::Work(std::size_t index)
+{
+    Task task;
+
+    while (true)
+    {
+        if (Pop(index, task) || Steal(index, task))
+        {
+            Run(task);
+
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        mWakeUp.wait(lock, [this]() { return mStop || mQueued.load(std::memory_order_acquire) != 0; });
+
+        if (mStop)
+            return;
+    }
+}
+
+inline bool ThreadPool::Pop(std::size_t index, Task &task)
+{
+    Worker &worker = *mWorkers[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+
+    if (worker.tasks.empty())
+        return false;
+
+    task = worker.tasks.back();
+    worker.tasks.pop_back();
+    mQueued.fetch_sub(1, std::memory_order_relaxed);
+
+    return true;
+}
+
+// steal from the other workers starting from the thief's neighbour (thief is Workers() for non worker threads)
+inline bool ThreadPool::Steal(std::size_t thief, Task &task)
+{
+    for (std::size_t i = 1; i <= mWorkers.size(); i++)
+    {
+        Worker &worker = *mWorkers[(thief + i) % mWorkers.size()];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+
+        if (!worker.tasks.empty())
+        {
+            task = worker.tasks.front();
+            worker.tasks.pop_front();
+            mQueued.fetch_sub(1, std::memory_order_relaxed);
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+inline void ThreadPool::Run(Task const &task)
+{
+    Loop &loop = *task.loop;
+
+    try
+    {
+        loop.run(loop.body, task.begin, task.end);
+    }
+    catch (...)
+    {
+        std::lock_guard<std::mutex> lock(loop.exceptionMutex);
+
+        if (!loop.exception)
+            loop.exception = std::current_exception();
+    }
+
+    loop.pending.fetch_sub(1, std::memory_order_acq_rel);     // the loop may be destroyed as soon as pending is 0
+}
+
+#endif  // THREAD_POOL_H
@@ -0,0 +1,392 @@
+#ifndef CONCURRENT_SIGNAL_H
+#define CONCURRENT_SIGNAL_H
+
+#include "signal.hpp"
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+#include <memory>
+#include <new>
+
+/***** concurrent signal typedefs *****/
+#define CONCURRENT_SIGNAL(SignalType)                                  typedef ConcurrentSignal<void()> SignalType
+#define CONCURRENT_SIGNAL_ONE_PARAM(SignalType, par0)                  typedef ConcurrentSignal<void(par0)> SignalType
+#define CONCURRENT_SIGNAL_TWO_PARAM(SignalType, par0, par1)            typedef ConcurrentSignal<void(par0, par1)> SignalType
+
+#define CONCURRENT_SIGNAL_RET(SignalType, ret)                         typedef ConcurrentSignal<ret()> SignalType
+#define CONCURRENT_SIGNAL_RET_ONE_PARAM(SignalType, ret, par0)         typedef ConcurrentSignal<ret(par0)> SignalType
+#define CONCURRENT_SIGNAL_RET_TWO_PARAM(SignalType, ret, par0, par1)   typedef ConcurrentSignal<ret(par0, par1)> SignalType
+
+/**************** reader epochs ****************/
+// epoch based reclamation shared by all the concurrent signals: every thread owns a reader record where it announces the
+// global epoch when it starts reading (a plain store to its own cache line, no shared counter is incremented) and clears it
+// when it's done; a snapshot retired at epoch E can be deleted once no reader announced an epoch older than E
+class ReaderEpochs
+{
+    struct Reader;
+public:
+    // marks the calling thread as reading for its lifetime (nested guards keep the epoch of the outermost one)
+    class ReadGuard
+    {
+    public:
+        ReadGuard();
+        ~ReadGuard();
+
+        ReadGuard(ReadGuard const&) = delete;
+        ReadGuard &operator=(ReadGuard const&) = delete;
+    private:
+        Reader &mReader;
+    };
+
+    // starts a new epoch, returns it
+    static std::uint64_t Advance() { return Epoch().fetch_add(1, std::memory_order_seq_cst) + 1; }
+
+    // oldest epoch announced by a reader (UINT64_MAX if no thread is reading)
+    static std::uint64_t Oldest();
+private:
+    // aligned so the records of different threads are on different cache lines
+    struct alignas(64) Reader
+    {
+        std::atomic<std::uint64_t> epoch{ 0 };     // 0 if not reading
+        std::atomic<bool> used{ true };             // owned by a thread
+        Reader *next = nullptr;
+        unsigned int depth = 0;                     // nesting of the owner thread's guards
+    };
+
+    static std::atomic<std::uint64_t> &Epoch() { static std::atomic<std::uint64_t> epoch{ 1 }; return epoch; }
+    static std::atomic<Reader*> &Readers() { static std::atomic<Reader*> readers{ nullptr }; return readers; }
+
+    static Reader &ThisThread();
+    static Reader *Acquire();
+};
+
+inline ReaderEpochs::ReadGuard::ReadGuard() : mReader(ThisThread())
+{
+    if (mReader.depth++ == 0)
+        mReader.epoch.store(Epoch().load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+}
+
+inline ReaderEpochs::ReadGuard::~ReadGuard()
+{
+    if (--mReader.depth == 0)
+        mReader.epoch.store(0, std::memory_order_release);
+}
+
+inline std::uint64_t ReaderEpochs::Oldest()
+{
+    std::uint64_t oldest = std::uint64_t(-1);
+
+    for (Reader *reader = Readers().load(std::memory_order_acquire); reader; reader = reader->next)
+    {
+        std::uint64_t epoch = reader->epoch.load(std::memory_order_seq_cst);
+
+        if (epoch != 0 && epoch < oldest)
+            oldest = epoch;
+    }
+
+    return oldest;
+}
+
+// the calling thread's record, released (not deleted) when the thread exits so other threads can reuse it
+inline ReaderEpochs::Reader &ReaderEpochs::ThisThread()
+{
+    struct Owner
+    {
+        Reader *reader = Acquire();
+        ~Owner() { reader->used.store(false, std::memory_order_release); }
+    };
+
+    static thread_local Owner owner;
+
+    return *owner.reader;
+}
+
+inline ReaderEpochs::Reader *ReaderEpochs::Acquire()
+{
+    for (Reader *reader = Readers().load(std::memory_order_acquire); reader; reader = reader->next)
+    {
+        bool used = false;
+
+        if (reader->used.compare_exchange_strong(used, true, std::memory_order_acquire))
+            return reader;
+    }
+
+    // c++14 new doesn't honor alignments stricter than max_align_t, the block is aligned by hand (records are never deleted)
+    std::size_t space = sizeof(Reader) + alignof(Reader);
+    void *block = ::operator new(space);
+    Reader *reader = new(std::align(alignof(Reader), sizeof(Reader), block, space)) Reader;
+    reader->next = Readers().load(std::memory_order_relaxed);
+
+    while (!Readers().compare_exchange_weak(reader->next, reader, std::memory_order_release, std::memory_order_relaxed))
+        ;
+
+    return reader;
+}
+
+/**************** concurrent signal ****************/
+
+/**** concurrent signal primary class template (not defined) ****/
+template <typename Signature>
+class ConcurrentSignal;
+
+/**** concurrent signal partial class template for function types ****/
+// thread safe signal for listener sets that are emitted much more often than they change: emission reads an immutable
+// snapshot of the delegates without locking, binding and disconnecting (serialized by a mutex) publish a new snapshot and
+// retire the old one; a retired snapshot is deleted by the next write or by the emission that finishes last among the ones
+// that could be reading it (it takes the mutex only if it's free); function objects bound as rvalues are copied into every
+// snapshot, so their state isn't shared between snapshots (and they must be safe to call concurrently)
+template <typename Ret, typename... Args>
+class ConcurrentSignal<Ret(Args...)>
+{
+public:
+    ConcurrentSignal() = default;
+
+    ConcurrentSignal(ConcurrentSignal const&) = delete;
+
+    ~ConcurrentSignal();
+
+    ConcurrentSignal &operator=(ConcurrentSignal const&) = delete;
+
+    // binding a function/instance pair that's already bound fails and returns a null connection
+    template <Ret(*FreeFunction)(Args...)>
+    Connection Bind();
+
+    template <typename Type, Ret(Type::*PtrToMemFun)(Args...)>
+    Connection Bind(Type &instance);
+
+    template <typename Type, Ret(Type::*PtrToConstMemFun)(Args...) const>
+    Connection Bind(Type &instance);
+
+    template <typename Type>
+    Connection Bind(Type &&funObj);
+
+    // the delegate can still be called by emissions that started before disconnecting
+    bool Disconnect(Connection const &connection);
+
+    bool Connected(Connection const &connection) const;
+
+    void Clear();
+
+    template <Ret(*FreeFunction)(Args...)>
+    bool Unbind();
+
+    template <typename Type, Ret(Type::*PtrToMemFun)(Args...)>
+    bool Unbind(Type &instance);
+
+    template <typename Type, Ret(Type::*PtrToConstMemFun)(Args...) const>
+    bool Unbind(Type &instance);
+
+    template <typename Type, typename = std::enable_if_t<!std::is_same<std::remove_cv_t<Type>, Delegate<Ret(Args...)>>::value>>
+    bool Unbind(Type &funObj);
+
+    explicit operator bool() const { return mSnapshot.load(std::memory_order_acquire) != nullptr; }
+
+    void operator()(Args... args) const;
+    void Invoke(Args... args) const { (*this)(args...); }
+private:
+    struct Snapshot
+    {
+        std::vector<Delegate<Ret(Args...)>> delegates;
+        std::uint64_t epoch;        // epoch when the snapshot was retired
+        Snapshot *next;             // next retired snapshot
+    };
+
+    std::atomic<Snapshot*> mSnapshot{ nullptr };     // null if no delegate is bound
+
+    mutable std::mutex mMutex;                      // serializes the writers (and the emissions reclaiming snapshots)
+    Signal<Ret(Args...)> mSignal;                   // delegates of the next snapshot
+    mutable Snapshot *mRetired = nullptr;           // snapshots that may still be read
+    mutable std::atomic<bool> mPending{ false };    // mRetired isn't empty
+
+    template <typename Result>
+    Result Update(Result result);
+
+    void Publish();
+    void Reclaim() const;
+};
+
+template <typename Ret, typename... Args>
+ConcurrentSignal<Ret(Args...)>::~ConcurrentSignal()
+{
+    delete mSnapshot.load(std::memory_order_relaxed);
+
+    while (mRetired)
+    {
+        Snapshot *next = mRetired->next;
+        delete mRetired;
+        mRetired = next;
+    }
+}
+
+template <typename Ret, typename... Args>
+template <Ret(*FreeFunction)(Args...)>
+Connection ConcurrentSignal<Ret(Args...)>::Bind()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    return Update(mSignal.template Bind<FreeFunction>());
+}
+
+template <typename Ret, typename... Args>
+template <typename Type, Ret(Type::*PtrToMemFun)(Args...)>
+Connection ConcurrentSignal<Ret(Args...)>::Bind(Type &instance)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    return Update(mSignal.template Bind<Type, PtrToMemFun>(instance));
+}
+
+template <typename Ret, typename... Args>
+template <typename Type, Ret(Type::*PtrToConstMemFun)(Args...) const>
+Connection ConcurrentSignal<Ret(Args...)>::Bind(Type &instance)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    return Update(mSignal.template Bind<Type, PtrToConstMemFun>(instance));
+}
+
+template <typename Ret, typename... Args>
+template <typename Type>
+Connection ConcurrentSignal<Ret(Args...)>::Bind(Type &&funObj)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    return Update(mSignal.Bind(std::forward<Type>(funObj)));
+}
+
+template <typename Ret, typename... Args>
+bool ConcurrentSignal<Ret(Args...)>::Disconnect(Connection const &connection)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    return Update(mSignal.Disconnect(connection));
+}
+
+template <typename Ret, typename... Args>
+bool ConcurrentSignal<Ret(Args...)>::Connected(Connection const &connection) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    return mSignal.Connected(connection);
+}
+
+template <typename Ret, typename... Args>
+void ConcurrentSignal<Ret(Args...)>::Clear()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    mSignal.Clear();
+    Publish();
+}
+
+template <typename Ret, typename... Args>
+template <Ret(*FreeFunction)(Args...)>
+bool ConcurrentSignal<Ret(Args...)>::Unbind()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    return Update(mSignal.template Unbind<FreeFunction>());
+}
+
+template <typename Ret, typename... Args>
+template <typename Type, Ret(Type::*PtrToMemFun)(Args...)>
+bool ConcurrentSignal<Ret(Args...)>::Unbind(Type &instance)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    return Update(mSignal.template Unbind<Type, PtrToMemFun>(instance));
+}
+
+template <typename Ret, typename... Args>
+template <typename Type, Ret(Type::*PtrToConstMemFun)(Args...) const>
+bool ConcurrentSignal<Ret(Args...)>::Unbind(Type &instance)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    return Update(mSignal.template Unbind<Type, PtrToConstMemFun>(instance));
+}
+
+template <typename Ret, typename... Args>
+template <typename Type, typename>
+bool ConcurrentSignal<Ret(Args...)>::Unbind(Type &funObj)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    return Update(mSignal.Unbind(funObj));
+}
+
+template <typename Ret, typename... Args>
+void ConcurrentSignal<Ret(Args...)>::operator()(Args... args) const
+{
+    {
+        ReaderEpochs::ReadGuard guard;
+
+        Snapshot *snapshot = mSnapshot.load(std::memory_order_seq_cst);
+
+        if (snapshot)
+            for (auto &delegate : snapshot->delegates)
+                delegate(args...);
+    }
+
+    // don't leave retired snapshots alive until the next write, but don't wait for a writer either
+    if (mPending.load(std::memory_order_relaxed))
+    {
+        std::unique_lock<std::mutex> lock(mMutex, std::try_to_lock);
+
+        if (lock)
+            Reclaim();
+    }
+}
+
+// publish a new snapshot if the signal's delegates changed (result converts to true)
+template <typename Ret, typename... Args>
+template <typename Result>
+Result ConcurrentSignal<Ret(Args...)>::Update(Result result)
+{
+    if (result)
+        Publish();
+
+    return result;
+}
+
+template <typename Ret, typename... Args>
+void ConcurrentSignal<Ret(Args...)>::Publish()
+{
+    if (mSignal.mTombstones)
+        mSignal.Compact();      // snapshots only hold bound delegates
+
+    Snapshot *snapshot = mSignal.mDelegates.empty() ? nullptr : new Snapshot{ mSignal.mDelegates, 0, nullptr };
+    Snapshot *old = mSnapshot.exchange(snapshot, std::memory_order_seq_cst);
+
+    if (old)
+    {
+        old->epoch = ReaderEpochs::Advance();   // readers announcing this epoch or a newer one read the new snapshot
+        old->next = mRetired;
+        mRetired = old;
+    }
+
+    Reclaim();
+}
+
+template <typename Ret, typename... Args>
+void ConcurrentSignal<Ret(Args...)>::Reclaim() const
+{
+    if (!mRetired)
+        return;
+
+    std::uint64_t oldest = ReaderEpochs::Oldest();
+
+    for (Snapshot **retired = &mRetired; *retired;)
+        if ((*retired)->epoch <= oldest)
+        {
+            Snapshot *next = (*retired)->next;
+            delete *retired;
+            *retired = next;
+        }
+        else
+            retired = &(*retired)->next;
+
+    mPending.store(mRetired != nullptr, std::memory_order_relaxed);
+}
+
+#endif  // CONCURRENT_SIGNAL_H
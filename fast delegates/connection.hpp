@@ -0,0 +1,40 @@
+#ifndef CONNECTION_H
+#define CONNECTION_H
+
+#include <cstdint>
+#include <atomic>
+
+template <typename Signature>
+class Signal;
+
+// handle to a delegate bound to a signal: index of the signal's slot plus the generation of the slot when the delegate was bound 
+// (a slot's generation changes every time its delegate is unbound, so stale handles are detected; the generations of every 
+// signal start from a different salt, so handles to other signals are detected too)
+class Connection
+{
+template <typename Signature>
+friend class Signal;
+public:
+    Connection() : mSlot(0), mGeneration(0) {}   // null object (generations start from 1)
+
+    explicit operator bool() const { return mGeneration != 0; }
+private:
+    Connection(std::uint32_t slot, std::uint32_t generation) : mSlot(slot), mGeneration(generation) {}
+
+    static std::uint32_t NextSalt();
+
+    std::uint32_t mSlot;
+    std::uint32_t mGeneration;
+};
+
+// spread the salts of consecutive signals over the generation range (golden ratio increments)
+inline std::uint32_t Connection::NextSalt()
+{
+    static std::atomic<std::uint32_t> signals{ 0 };
+
+    std::uint32_t salt = signals.fetch_add(1, std::memory_order_relaxed) * 0x9E3779B9u;
+
+    return salt != 0 ? salt : 1;    // generation 0 is reserved for null connections
+}
+
+#endif  // CONNECTION_H
@@ -5,6 +5,29 @@
 #include <utility>
 #include <new>
 #include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <cstdint>
+#include <functional>
+
+/***** unbound delegate policy (what an unbound delegate does when invoked) *****/
+#define DELEGATE_UNBOUND_THROW      0   // throw DelegateNotBoundException
+#define DELEGATE_UNBOUND_ABORT      1   // call std::abort
+#define DELEGATE_UNBOUND_DEFAULT    2   // return a value-initialized Ret
+
+#ifndef DELEGATE_UNBOUND_POLICY
+#define DELEGATE_UNBOUND_POLICY DELEGATE_UNBOUND_THROW
+#endif
+
+/***** delegate exceptions *****/
+class DelegateNotBoundException : public std::exception
+{
+public:
+    const char *what() const noexcept override
+    {
+        return "delegate not bound";
+    }
+};
 
 /**** delegate primary class template (not defined) ****/
 template <typename Signature>
@@ -17,22 +40,27 @@ void swap(Delegate<Signature> &d1, Delegate<Signature> &d2)
     d1.Swap(d2);
 }
 
+/**** forward declaration (for friend declaration inside Delegate) ****/
+template <typename Signature>
+class Signal;
+
 /**** delegate partial class template for function types ****/
 template <typename Ret, typename... Args>
 class Delegate<Ret(Args...)>
 {
+friend class Signal<Ret(Args...)>;
 public:
     Delegate();
 
     Delegate(Delegate const &other);
 
-    Delegate(Delegate &&other);
+    Delegate(Delegate &&other) noexcept;
 
     ~Delegate();
 
     Delegate &operator=(Delegate const &other);
 
-    Delegate &operator=(Delegate &&other);
+    Delegate &operator=(Delegate &&other) noexcept;
 
     template <Ret(*FreeFunction)(Args...)>
     void Bind();
@@ -51,7 +79,13 @@ public:
 
     void Swap(Delegate &other);
 
-    explicit operator bool() const { return mFunction != nullptr; }
+    explicit operator bool() const { return mFunction != &UnboundStub; }
+
+    // two delegates are equal if they call the same function on the same instance (delegates owning a function object are only equal to themselves)
+    bool operator==(Delegate const &other) const;
+    bool operator!=(Delegate const &other) const { return !(*this == other); }
+
+    std::size_t Hash() const;
 
     template <typename... FwdArgs>
     Ret operator()(FwdArgs&&... args) { return mFunction(&mData, std::forward<FwdArgs>(args)...); }
@@ -63,18 +97,50 @@ private:
     using Storage = std::aligned_storage_t<sizeof(void*), alignof(void*)> ;
     using Function = Ret(*)(Storage /*void*/ *, Args...);
     
+    using DestroyStorageFunction = void(*)(Delegate*);
+    using CopyStorageFunction = void(*)(const Delegate*, Delegate*);
+    using MoveStorageFunction = void(*)(Delegate*, Delegate*);
+
+    // lifetime functions of a stored function object (one static table per stored type)
+    struct StorageManager
+    {
+        DestroyStorageFunction destroy;
+        CopyStorageFunction copy;
+        MoveStorageFunction move;
+    };
+
     Storage mData;
     Function mFunction;
 
-    bool mStored = false;
+    StorageManager const *mManager = nullptr;   // null if the storage is trivially copyable (free functions, member functions, lvalue function objects)
 
-    using DestroyStorageFunction = void(*)(Delegate*);
-    using CopyStorageFunction = void(*)(const Delegate*, Delegate*);
-    using MoveStorageFunction = void(*)(Delegate*, Delegate*);
+    // bound instance (or null for free functions) if the delegate doesn't own its function object
+    void const *Target() const { return *reinterpret_cast<void* const*>(&mData); }
 
-    DestroyStorageFunction mDestroyStorage = nullptr;
-    CopyStorageFunction mCopyStorage = nullptr;
-    MoveStorageFunction mMoveStorage = nullptr;
+    void CopyFrom(Delegate const &other);
+    void MoveFrom(Delegate &other);
+    void Reset();
+
+    /**** stub installed in unbound delegates (invoking a delegate never tests if it's bound) ****/
+    static Ret UnboundStub(Storage /*void*/ *, Args...)
+    {
+#if DELEGATE_UNBOUND_POLICY == DELEGATE_UNBOUND_THROW
+        throw DelegateNotBoundException();
+#elif DELEGATE_UNBOUND_POLICY == DELEGATE_UNBOUND_ABORT
+        std::abort();
+#else
+        static_assert(!std::is_reference<Ret>::value, "an unbound delegate can't return a default reference");
+        return Ret();
+#endif
+    }
+
+    template <typename Type>
+    static StorageManager const *Manager()
+    {
+        static const StorageManager manager{ &DestroyStorage<Type>, &CopyStorage<Type>, &MoveStorage<Type> };
+
+        return &manager;
+    }
 
     /**** helper function templates for special member functions ****/
     template <typename Type>
@@ -152,52 +218,25 @@ Delegate<Ret(Args...)>::Delegate()
 {
     new(&mData) std::nullptr_t(nullptr);
 
-    mFunction = nullptr;
+    mFunction = &UnboundStub;
 }
 
 template <typename Ret, typename... Args>
 Delegate<Ret(Args...)>::Delegate(Delegate const &other)
 {
-    if (other.mStored)
-    {
-        other.mCopyStorage(&other, this);
-
-        mDestroyStorage = other.mDestroyStorage;
-        mCopyStorage = other.mCopyStorage;
-        mMoveStorage = other.mMoveStorage;
-
-        mStored = true;
-    }
-    else
-        mData = other.mData;
-
-    mFunction = other.mFunction;
+    CopyFrom(other);
 }
 
 template <typename Ret, typename... Args>
-Delegate<Ret(Args...)>::Delegate(Delegate &&other)
+Delegate<Ret(Args...)>::Delegate(Delegate &&other) noexcept
 {
-    if (other.mStored)
-    {
-        other.mMoveStorage(&other, this);
-
-        mDestroyStorage = other.mDestroyStorage;
-        mCopyStorage = other.mCopyStorage;
-        mMoveStorage = other.mMoveStorage;
-
-        mStored = true;
-    }
-    else
-        mData = other.mData;
-
-    mFunction = other.mFunction;
+    MoveFrom(other);
 }
 
 template <typename Ret, typename... Args>
 Delegate<Ret(Args...)>::~Delegate()
 {
-    if (mStored)
-        mDestroyStorage(this);
+    Reset();
 }
 
 template <typename Ret, typename... Args>
@@ -210,7 +249,7 @@ Delegate<Ret(Args...)> &Delegate<Ret(Args...)>::operator=(Delegate const &other)
 }
 
 template <typename Ret, typename... Args>
-Delegate<Ret(Args...)> &Delegate<Ret(Args...)>::operator=(Delegate &&other)
+Delegate<Ret(Args...)> &Delegate<Ret(Args...)>::operator=(Delegate &&other) noexcept
 {
     Delegate temp(std::move(other));
     Swap(temp);
@@ -222,6 +261,8 @@ template <typename Ret, typename... Args>
 template <Ret(*FreeFunction)(Args...)>
 void Delegate<Ret(Args...)>::Bind()
 {
+    Reset();
+
     new(&mData) std::nullptr_t(nullptr);
 
     mFunction = &Stub<FreeFunction>;
@@ -231,6 +272,8 @@ template <typename Ret, typename... Args>
 template <typename Type, Ret(Type::*PtrToMemFun)(Args...)>
 void Delegate<Ret(Args...)>::Bind(Type &instance)
 {
+    Reset();
+
     new(&mData) Type*(&instance);
 
     mFunction = &Stub<Type, PtrToMemFun>;
@@ -240,6 +283,8 @@ template <typename Ret, typename... Args>
 template <typename Type, Ret(Type::*PtrToConstMemFun)(Args...) const>
 void Delegate<Ret(Args...)>::Bind(Type &instance)
 {
+    Reset();
+
     new(&mData) Type*(&instance);
 
     mFunction = &Stub<Type, PtrToConstMemFun>;
@@ -249,6 +294,8 @@ template <typename Ret, typename... Args>
 template <typename Type>
 void Delegate<Ret(Args...)>::Bind(Type &funObj)   
 {
+    Reset();
+
     new(&mData) Type*(&funObj);    
 
     mFunction = &Stub<Type>;
@@ -258,46 +305,93 @@ template <typename Ret, typename... Args>
 template <typename Type>
 void Delegate<Ret(Args...)>::Bind(Type &&funObj)
 {
-    static_assert(sizeof(Type) <= sizeof(void*));
+    Reset();
+
+    static_assert(sizeof(Type) <= sizeof(void*), "function objects bound as rvalues must fit in a pointer");
+    static_assert(std::is_nothrow_move_constructible<Type>::value, "function objects bound as rvalues must be nothrow movable");   // (delegates move without throwing)
 
     new(&mData) Type(std::move(funObj));    
 
     mFunction = &Stub<Type, Type>;
 
-    mDestroyStorage = &DestroyStorage<Type>;
-    mCopyStorage = &CopyStorage<Type>;
-    mMoveStorage = &MoveStorage<Type>;
-
-    mStored = true;
+    mManager = Manager<Type>();
 }
 
 template <typename Ret, typename... Args>
 void Delegate<Ret(Args...)>::Swap(Delegate &other)
 {
-    if (other.mStored)
-        other.mCopyStorage(&other, this);
+    Delegate temp(std::move(other));
+
+    other.Reset();
+    other.MoveFrom(*this);
+
+    Reset();
+    MoveFrom(temp);
+}
+
+template <typename Ret, typename... Args>
+bool Delegate<Ret(Args...)>::operator==(Delegate const &other) const
+{
+    if (mManager || other.mManager)
+        return this == &other;
+
+    return mFunction == other.mFunction && Target() == other.Target();
+}
+
+template <typename Ret, typename... Args>
+std::size_t Delegate<Ret(Args...)>::Hash() const
+{
+    std::size_t functionHash = std::hash<std::uintptr_t>()(reinterpret_cast<std::uintptr_t>(mFunction));
+    std::size_t targetHash = std::hash<void const*>()(mManager ? this : Target());
+
+    return functionHash ^ (targetHash + 0x9e3779b9 + (functionHash << 6) + (functionHash >> 2));
+}
+
+template <typename Ret, typename... Args>
+void Delegate<Ret(Args...)>::CopyFrom(Delegate const &other)
+{
+    if (other.mManager)
+        other.mManager->copy(&other, this);
+    else
+        mData = other.mData;
+
+    mManager = other.mManager;
+    mFunction = other.mFunction;
+}
+
+template <typename Ret, typename... Args>
+void Delegate<Ret(Args...)>::MoveFrom(Delegate &other)
+{
+    if (other.mManager)
+        other.mManager->move(&other, this);
     else
-         mData = other.mData;
+        mData = other.mData;
 
-    Function tempFunction = mFunction;
+    mManager = other.mManager;
     mFunction = other.mFunction;
-    other.mFunction = tempFunction;
+}
+
+// destroy the stored function object (if any) and leave the delegate unbound
+template <typename Ret, typename... Args>
+void Delegate<Ret(Args...)>::Reset()
+{
+    if (mManager)
+        mManager->destroy(this);
 
-    bool tempStored = mStored;
-    mStored = other.mStored;
-    other.mStored = tempStored;
+    new(&mData) std::nullptr_t(nullptr);
+    mFunction = &UnboundStub;
 
-    DestroyStorageFunction tempDestroyFun = mDestroyStorage;
-    mDestroyStorage = other.mDestroyStorage;
-    other.mDestroyStorage = tempDestroyFun;
+    mManager = nullptr;
+}
 
-    CopyStorageFunction tempCopyFun = mCopyStorage;
-    mCopyStorage = other.mCopyStorage;
-    other.mCopyStorage = tempCopyFun;
-    
-    MoveStorageFunction tempMoveFun = mMoveStorage;
-    mMoveStorage = other.mMoveStorage;
-    other.mMoveStorage = tempMoveFun;
+/**** hash specialization (for unordered containers) ****/
+namespace std
+{
+    template <typename Signature>
+    struct hash<Delegate<Signature>>
+    {
+        std::size_t operator()(Delegate<Signature> const &delegate) const noexcept { return delegate.Hash(); }
+    };
 }
 
 #endif  // DELEGATE_H
\ No newline at end of file
@@ -69,10 +69,15 @@ int main(int argc, char **argv)
     md1.Bind<&MyClass::StaticMemberFunction>();
     md1.Bind(mc);
     md1.Bind(cmc);
-    md1.Bind(lambda);
-    md1.Bind([&i](double d){ std::cout << "in rvalue lambda" << std::endl; return i * d; });
+    Connection lambdaConnection = md1.Bind(lambda);
+    Connection rvalueLambdaConnection = md1.Bind([&i](double d){ std::cout << "in rvalue lambda" << std::endl; return i * d; });
     
     md1(1.20);
 
+    md1.Disconnect(lambdaConnection);
+    md1.Disconnect(rvalueLambdaConnection);
+
+    md1(1.20);
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,211 @@
+#ifndef QUEUED_SIGNAL_H
+#define QUEUED_SIGNAL_H
+
+#include "signal.hpp"
+#include <tuple>
+#include <mutex>
+#include <condition_variable>
+#include <new>
+#include <utility>
+
+/***** queued signal typedefs *****/
+#define QUEUED_SIGNAL(SignalType)                           typedef QueuedSignal<void()> SignalType
+#define QUEUED_SIGNAL_ONE_PARAM(SignalType, par0)           typedef QueuedSignal<void(par0)> SignalType
+#define QUEUED_SIGNAL_TWO_PARAM(SignalType, par0, par1)     typedef QueuedSignal<void(par0, par1)> SignalType
+
+/***** what posting to a full queue does *****/
+enum class QueueOverflowPolicy
+{
+    Block,  // wait until a flush makes room (a listener posting to the queue its thread is flushing grows it instead)
+    Drop,   // discard the event
+    Grow    // double the queue's capacity
+};
+
+/**** queued signal primary class template (not defined) ****/
+template <typename Signature>
+class QueuedSignal;
+
+/**** queued signal partial class template for void function types ****/
+// signal whose events can be posted and emitted later: posting copies the arguments into a ring buffer of events
+// (no allocation unless the queue grows), flushing emits the queued events in order; posting and flushing are thread safe,
+// binding and emitting directly are not (the signal's delegates are called by the flushing thread)
+template <typename... Args>
+class QueuedSignal<void(Args...)> : public Signal<void(Args...)>
+{
+public:
+    // the capacity is rounded up to a power of two
+    explicit QueuedSignal(std::size_t capacity = 1024, QueueOverflowPolicy policy = QueueOverflowPolicy::Grow);
+
+    QueuedSignal(QueuedSignal const&) = delete;
+
+    ~QueuedSignal();
+
+    QueuedSignal &operator=(QueuedSignal const&) = delete;
+
+    // copies the arguments (decayed, references are copied as values), returns false if the event was dropped
+    template <typename... PostArgs>
+    bool Post(PostArgs&&... args);
+
+    // emits the events queued before the call (events posted while flushing are emitted by the next flush)
+    void Flush();
+
+    // discards the queued events
+    void Discard();
+
+    std::size_t Size() const { std::lock_guard<std::mutex> lock(mMutex); return mSize; }
+    std::size_t Capacity() const { std::lock_guard<std::mutex> lock(mMutex); return mCapacity; }
+private:
+    using Event = std::tuple<std::decay_t<Args>...>;
+    using EventStorage = std::aligned_storage_t<sizeof(Event), alignof(Event)>;
+
+    EventStorage *mEvents;
+    std::size_t mCapacity;
+    std::size_t mHead = 0;      // position of the oldest event
+    std::size_t mSize = 0;
+
+    QueueOverflowPolicy mPolicy;
+
+    mutable std::mutex mMutex;
+    std::condition_variable mNotFull;
+
+    Event &At(std::size_t index) { return *reinterpret_cast<Event*>(mEvents + ((mHead + index) & (mCapacity - 1))); }
+
+    void Grow();
+
+    // marks the signal as flushed by the calling thread for its lifetime (posting to it must not wait for a flush then)
+    class FlushGuard
+    {
+    public:
+        explicit FlushGuard(QueuedSignal const &signal) : mSignal(signal), mOuter(Top()) { Top() = this; }
+        ~FlushGuard() { Top() = mOuter; }
+
+        FlushGuard(FlushGuard const&) = delete;
+        FlushGuard &operator=(FlushGuard const&) = delete;
+
+        static bool Flushing(QueuedSignal const &signal);
+    private:
+        static FlushGuard const *&Top() { static thread_local FlushGuard const *top = nullptr; return top; }
+
+        QueuedSignal const &mSignal;
+        FlushGuard const *mOuter;   // guard of a flush the current one is nested in
+    };
+
+    template <std::size_t... Indices>
+    void Emit(Event &event, std::index_sequence<Indices...>) { Signal<void(Args...)>::operator()(std::get<Indices>(event)...); }
+};
+
+template <typename... Args>
+QueuedSignal<void(Args...)>::QueuedSignal(std::size_t capacity, QueueOverflowPolicy policy) : mCapacity(1), mPolicy(policy)
+{
+    while (mCapacity < capacity)
+        mCapacity *= 2;
+
+    mEvents = new EventStorage[mCapacity];
+}
+
+template <typename... Args>
+QueuedSignal<void(Args...)>::~QueuedSignal()
+{
+    Discard();
+
+    delete[] mEvents;
+}
+
+template <typename... Args>
+template <typename... PostArgs>
+bool QueuedSignal<void(Args...)>::Post(PostArgs&&... args)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    if (mSize == mCapacity)
+        switch (mPolicy)
+        {
+        case QueueOverflowPolicy::Block:
+            if (FlushGuard::Flushing(*this))
+                Grow();     // the flush making room is the one calling this listener
+            else
+                mNotFull.wait(lock, [this]() { return mSize != mCapacity; });
+            break;
+        case QueueOverflowPolicy::Drop:
+            return false;
+        case QueueOverflowPolicy::Grow:
+            Grow();
+            break;
+        }
+
+    new(&At(mSize)) Event(std::forward<PostArgs>(args)...);
+    mSize++;
+
+    return true;
+}
+
+template <typename... Args>
+void QueuedSignal<void(Args...)>::Flush()
+{
+    FlushGuard guard(*this);
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    // the events are moved out of the queue one at a time so that posting isn't blocked while emitting
+    for (std::size_t count = mSize; count != 0 && mSize != 0; count--)
+    {
+        Event event(std::move(At(0)));
+
+        At(0).~Event();
+        mHead = (mHead + 1) & (mCapacity - 1);
+        mSize--;
+
+        lock.unlock();
+        mNotFull.notify_one();
+
+        Emit(event, std::index_sequence_for<Args...>());
+
+        lock.lock();
+    }
+}
+
+template <typename... Args>
+void QueuedSignal<void(Args...)>::Discard()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        for (std::size_t i = 0; i < mSize; i++)
+            At(i).~Event();
+
+        mHead = 0;
+        mSize = 0;
+    }
+
+    mNotFull.notify_all();
+}
+
+// double the capacity (moving the events to the start of the new buffer)
+template <typename... Args>
+void QueuedSignal<void(Args...)>::Grow()
+{
+    EventStorage *events = new EventStorage[2 * mCapacity];
+
+    for (std::size_t i = 0; i < mSize; i++)
+    {
+        new(events + i) Event(std::move(At(i)));
+        At(i).~Event();
+    }
+
+    delete[] mEvents;
+
+    mEvents = events;
+    mCapacity *= 2;
+    mHead = 0;
+}
+
+template <typename... Args>
+bool QueuedSignal<void(Args...)>::FlushGuard::Flushing(QueuedSignal const &signal)
+{
+    for (FlushGuard const *guard = Top(); guard; guard = guard->mOuter)
+        if (&guard->mSignal == &signal)
+            return true;
+
+    return false;
+}
+
+#endif  // QUEUED_SIGNAL_H
@@ -2,7 +2,11 @@
 #define SIGNAL_H
 
 #include "delegate.hpp"
+#include "connection.hpp"
+#include "thread_pool.hpp"
 #include <vector>
+#include <tuple>
+#include <cstdint>
 
 /***** signal typedefs *****/
 #define SIGNAL(SignalType)                                  typedef Signal<void()> SignalType
@@ -13,69 +17,696 @@
 #define SIGNAL_RET_ONE_PARAM(SignalType, ret, par0)         typedef Signal<ret(par0)> SignalType
 #define SIGNAL_RET_TWO_PARAM(SignalType, ret, par0, par1)   typedef Signal<ret(par0, par1)> SignalType
 
+/**** delegate index ****/
+// open addressing (linear probing) hash table of the positions of the delegates in a signal's array:
+// the buckets are a single array growing geometrically, so indexing a delegate doesn't allocate
+template <typename DelegateType>
+class DelegateIndex
+{
+public:
+    static constexpr std::uint32_t NoPosition = std::uint32_t(-1);
+
+    // position of a delegate equal to the given one (NoPosition if not indexed)
+    std::uint32_t Find(DelegateType const &delegate, DelegateType const *delegates) const;
+
+    // index the delegate at the given position, returns false if an equal delegate is already indexed
+    bool Insert(DelegateType const *delegates, std::uint32_t position);
+
+    void Erase(DelegateType const &delegate, DelegateType const *delegates);
+
+    // the indexed delegate equal to the given one is moving to a new position
+    void Move(DelegateType const &delegate, DelegateType const *delegates, std::uint32_t position);
+
+    void Clear() { mBuckets.assign(mBuckets.size(), 0); mSize = 0; }
+private:
+    std::vector<std::uint32_t> mBuckets;    // position + 1 of each indexed delegate (0 if the bucket is empty)
+    std::size_t mSize = 0;
+
+    std::size_t Bucket(DelegateType const &delegate) const { return delegate.Hash() & (mBuckets.size() - 1); }
+    std::size_t FindBucket(DelegateType const &delegate, DelegateType const *delegates) const;
+    void Grow(DelegateType const *delegates);
+};
+
+template <typename DelegateType>
+constexpr std::uint32_t DelegateIndex<DelegateType>::NoPosition;
+
+template <typename DelegateType>
+std::size_t DelegateIndex<DelegateType>::FindBucket(DelegateType const &delegate, DelegateType const *delegates) const
+{
+    if (mBuckets.empty())
+        return mBuckets.size();
+
+    for (std::size_t bucket = Bucket(delegate); mBuckets[bucket] != 0; bucket = (bucket + 1) & (mBuckets.size() - 1))
+        if (delegates[mBuckets[bucket] - 1] == delegate)
+            return bucket;
+
+    return mBuckets.size();
+}
+
+template <typename DelegateType>
+std::uint32_t DelegateIndex<DelegateType>::Find(DelegateType const &delegate, DelegateType const *delegates) const
+{
+    std::size_t bucket = FindBucket(delegate, delegates);
+
+    return bucket == mBuckets.size() ? NoPosition : mBuckets[bucket] - 1;
+}
+
+template <typename DelegateType>
+bool DelegateIndex<DelegateType>::Insert(DelegateType const *delegates, std::uint32_t position)
+{
+    if (FindBucket(delegates[position], delegates) != mBuckets.size())
+        return false;
+
+    if (2 * (mSize + 1) > mBuckets.size())     // keep the load factor under 1/2
+        Grow(delegates);
+
+    std::size_t bucket = Bucket(delegates[position]);
+
+    while (mBuckets[bucket] != 0)
+        bucket = (bucket + 1) & (mBuckets.size() - 1);
+
+    mBuckets[bucket] = position + 1;
+    mSize++;
+
+    return true;
+}
+
+template <typename DelegateType>
+void DelegateIndex<DelegateType>::Erase(DelegateType const &delegate, DelegateType const *delegates)
+{
+    std::size_t hole = FindBucket(delegate, delegates);
+
+    if (hole == mBuckets.size())
+        return;
+
+    std::size_t mask = mBuckets.size() - 1;
+
+    // shift back the following entries of the probe sequence that can't be reached anymore (no tombstones)
+    for (std::size_t bucket = (hole + 1) & mask; mBuckets[bucket] != 0; bucket = (bucket + 1) & mask)
+    {
+        std::size_t home = Bucket(delegates[mBuckets[bucket] - 1]);
+
+        if (((bucket - home) & mask) >= ((bucket - hole) & mask))
+        {
+            mBuckets[hole] = mBuckets[bucket];
+            hole = bucket;
+        }
+    }
+
+    mBuckets[hole] = 0;
+    mSize--;
+}
+
+template <typename DelegateType>
+void DelegateIndex<DelegateType>::Move(DelegateType const &delegate, DelegateType const *delegates, std::uint32_t position)
+{
+    std::size_t bucket = FindBucket(delegate, delegates);
+
+    if (bucket != mBuckets.size())
+        mBuckets[bucket] = position + 1;
+}
+
+template <typename DelegateType>
+void DelegateIndex<DelegateType>::Grow(DelegateType const *delegates)
+{
+    std::vector<std::uint32_t> buckets(mBuckets.empty() ? 16 : 2 * mBuckets.size(), 0);
+    std::size_t mask = buckets.size() - 1;
+
+    for (std::uint32_t entry : mBuckets)
+        if (entry != 0)
+        {
+            std::size_t bucket = delegates[entry - 1].Hash() & mask;
+
+            while (buckets[bucket] != 0)
+                bucket = (bucket + 1) & mask;
+
+            buckets[bucket] = entry;
+        }
+
+    mBuckets.swap(buckets);
+}
+
+/**************** combiners ****************/
+// a combiner folds the results of the delegates called by an emission: it's called with each result and returns false
+// to stop the emission; combiners store their state by value, so combining results doesn't allocate
+
+/**** sum of the results ****/
+template <typename Type>
+class SumCombiner
+{
+public:
+    explicit SumCombiner(Type init = Type()) : mSum(init) {}
+
+    bool operator()(Type const &result) { mSum += result; return true; }
+
+    Type const &Result() const { return mSum; }
+private:
+    Type mSum;
+};
+
+/**** smallest result ****/
+template <typename Type>
+class MinCombiner
+{
+public:
+    bool operator()(Type const &result) { if (mEmpty || result < mMin) mMin = result; mEmpty = false; return true; }
+
+    bool Empty() const { return mEmpty; }
+    Type const &Result() const { return mMin; }     // value-initialized if there were no results
+private:
+    Type mMin = Type();
+    bool mEmpty = true;
+};
+
+/**** largest result ****/
+template <typename Type>
+class MaxCombiner
+{
+public:
+    bool operator()(Type const &result) { if (mEmpty || mMax < result) mMax = result; mEmpty = false; return true; }
+
+    bool Empty() const { return mEmpty; }
+    Type const &Result() const { return mMax; }     // value-initialized if there were no results
+private:
+    Type mMax = Type();
+    bool mEmpty = true;
+};
+
+/**** first result different from a value-initialized one (stops the emission) ****/
+template <typename Type>
+class FirstNonDefaultCombiner
+{
+public:
+    bool operator()(Type const &result) { if (result == Type()) return true; mResult = result; return false; }
+
+    Type const &Result() const { return mResult; }
+private:
+    Type mResult = Type();
+};
+
+/**** results copied into a caller-provided buffer (stops the emission when the buffer is full) ****/
+template <typename Type>
+class CollectCombiner
+{
+public:
+    CollectCombiner(Type *buffer, std::size_t capacity) : mBuffer(buffer), mCapacity(capacity) {}
+
+    bool operator()(Type const &result) { if (mSize == mCapacity) return false; mBuffer[mSize++] = result; return mSize != mCapacity; }
+
+    std::size_t Size() const { return mSize; }
+private:
+    Type *mBuffer;
+    std::size_t mCapacity;
+    std::size_t mSize = 0;
+};
+
+/**** custom left fold (result = operation(result, delegate's result)) ****/
+template <typename Type, typename BinaryOperation>
+class FoldCombiner
+{
+public:
+    FoldCombiner(Type init, BinaryOperation operation) : mResult(std::move(init)), mOperation(std::move(operation)) {}
+
+    bool operator()(Type const &result) { mResult = mOperation(std::move(mResult), result); return true; }
+
+    Type const &Result() const { return mResult; }
+private:
+    Type mResult;
+    BinaryOperation mOperation;
+};
+
+template <typename Type, typename BinaryOperation>
+FoldCombiner<Type, std::decay_t<BinaryOperation>> MakeFoldCombiner(Type init, BinaryOperation &&operation)
+{
+    return FoldCombiner<Type, std::decay_t<BinaryOperation>>(std::move(init), std::forward<BinaryOperation>(operation));
+}
+
+/**************** event batch ****************/
+// view of a contiguous array of events (tuples of decayed arguments) emitted together
+template <typename... Args>
+class EventBatch
+{
+public:
+    using Event = std::tuple<std::decay_t<Args>...>;
+
+    EventBatch(Event const *events, std::size_t size) : mEvents(events), mSize(size) {}
+    EventBatch(std::vector<Event> const &events) : mEvents(events.data()), mSize(events.size()) {}
+
+    template <std::size_t Size>
+    EventBatch(Event const (&events)[Size]) : mEvents(events), mSize(Size) {}
+
+    Event const *begin() const { return mEvents; }
+    Event const *end() const { return mEvents + mSize; }
+
+    Event const &operator[](std::size_t index) const { return mEvents[index]; }
+
+    std::size_t Size() const { return mSize; }
+    bool Empty() const { return mSize == 0; }
+private:
+    Event const *mEvents;
+    std::size_t mSize;
+};
+
+/**** batch listener detection (function objects callable with an event batch opt in to batched emission) ****/
+// the batch is passed as a braced list, which a templated call operator (generic lambda) can't deduce its parameter from:
+// the detection fails quietly instead of instantiating the operator's body with a batch
+template <typename Type, typename Batch, typename = void>
+struct IsBatchListener : std::false_type {};
+
+template <typename Type, typename... Args>
+struct IsBatchListener<Type, EventBatch<Args...>, decltype(void(std::declval<Type&>()({ std::declval<typename EventBatch<Args...>::Event const*>(), std::size_t() })))> : std::true_type {};
+
+/**** batch parameters check (the events of a batch are shared by the delegates, so they're passed as const lvalues) ****/
+template <bool... Values>
+struct BoolSequence {};
+
+template <typename Arg>
+using IsConstEventParameter = std::integral_constant<bool, !std::is_reference<Arg>::value || (std::is_lvalue_reference<Arg>::value && std::is_const<std::remove_reference_t<Arg>>::value)>;
+
+template <typename... Args>
+using AreConstEventParameters = std::is_same<BoolSequence<true, IsConstEventParameter<Args>::value...>, BoolSequence<IsConstEventParameter<Args>::value..., true>>;
+
+/**************** signal ****************/
 /**** signal primary class template (not defined) ****/
 template <typename Signature>
 class Signal;
 
+/**** forward declaration (for friend declaration inside Signal) ****/
+template <typename Signature>
+class ConcurrentSignal;
+
 /**** signal partial class template for function types ****/
 template <typename Ret, typename... Args>
 class Signal<Ret(Args...)>
 {
+friend class ConcurrentSignal<Ret(Args...)>;
 public:
+    // binding a function/instance pair that's already bound fails and returns a null connection;
+    // binding doesn't allocate (the signal's arrays grow geometrically)
     template <Ret(*FreeFunction)(Args...)>
-    void Bind();
+    Connection Bind();
 
     template <typename Type, Ret(Type::*PtrToMemFun)(Args...)>
-    void Bind(Type &instance);
+    Connection Bind(Type &instance);
     
     template <typename Type, Ret(Type::*PtrToConstMemFun)(Args...) const>
-    void Bind(Type &instance);
+    Connection Bind(Type &instance);
+
+    // an instance can also bind a member function receiving whole batches of events (called by EmitBatch)
+    template <typename Type, Ret(Type::*PtrToMemFun)(Args...), void(Type::*PtrToBatchMemFun)(EventBatch<Args...>)>
+    Connection Bind(Type &instance);
 
     template <typename Type>
-    void Bind(Type &&funObj);
+    Connection Bind(Type &&funObj);
+
+    // disconnecting is O(1) amortized and keeps the call order (the delegate leaves a tombstone, tombstones are removed 
+    // when they're half of the delegates), returns false if the connection is stale (already disconnected, signal cleared 
+    // or connection to another signal)
+    bool Disconnect(Connection const &connection);
 
-    explicit operator bool() const { return !mDelegates.empty(); }
+    bool Connected(Connection const &connection) const;
 
-    void operator()(Args... args) { for (auto &delegate : mDelegates) delegate(std::forward<Args>(args)...); }
-    void Invoke(Args... args) { for (auto &delegate : mDelegates) delegate->Invoke(std::forward<Args>(args)...); }
+    void Clear();
+
+    // unbinding is O(1) amortized like disconnecting;
+    // function objects bound as rvalues are owned by the signal and can only be disconnected
+    template <Ret(*FreeFunction)(Args...)>
+    bool Unbind();
+
+    template <typename Type, Ret(Type::*PtrToMemFun)(Args...)>
+    bool Unbind(Type &instance);
+    
+    template <typename Type, Ret(Type::*PtrToConstMemFun)(Args...) const>
+    bool Unbind(Type &instance);
+
+    template <typename Type, typename = std::enable_if_t<!std::is_same<std::remove_cv_t<Type>, Delegate<Ret(Args...)>>::value>>
+    bool Unbind(Type &funObj);
+
+    bool Unbind(Delegate<Ret(Args...)> const &delegate);
+
+    explicit operator bool() const { return mDelegates.size() != mTombstones; }
+
+    void operator()(Args... args);
+    void Invoke(Args... args);
+
+    // calls the delegates on the thread pool's threads (in no particular order), returns when all have returned; 
+    // the delegates must be safe to call concurrently and mustn't bind to or unbind from the signal
+    void InvokeParallel(Args... args) { InvokeParallel(ThreadPool::Instance(), args...); }
+    void InvokeParallel(ThreadPool &pool, Args... args);
+
+    // calls the delegates passing each result to the combiner (until the combiner returns false), returns the combiner
+    template <typename Combiner>
+    Combiner Combine(Combiner combiner, Args... args);
+
+    // emits a batch of events delegate by delegate: delegates accepting batches (function objects with a non-template call 
+    // operator taking an event batch, member functions bound with a batch member function) are called once with the whole 
+    // batch, the others once per event (the parameters must be values or const lvalue references)
+    void EmitBatch(EventBatch<Args...> events);
 private:
+    // slot map: delegates are kept in a dense array, connections refer to slots in a sparse array that track their delegate's position
+    struct Slot
+    {
+        std::uint32_t index;        // position in mDelegates (next free slot if the slot is free)
+        std::uint32_t generation;   
+    };
+
+    static constexpr std::uint32_t NoSlot = std::uint32_t(-1);
+
     std::vector<Delegate<Ret(Args...)>> mDelegates;
+    std::vector<std::uint32_t> mDelegateSlots;          // slot of each delegate in mDelegates (NoSlot if disconnected)
+    std::vector<Slot> mSlots;
+    std::uint32_t mFreeSlot = NoSlot;                   // head of the free slot list
+    std::uint32_t mSalt = Connection::NextSalt();       // generation of new slots (differs between signals, so connections to other signals don't match)
+    std::size_t mTombstones = 0;                        // disconnected delegates not removed yet
+    DelegateIndex<Delegate<Ret(Args...)>> mIndex;       // position of each delegate not owning its function object
+
+    using Storage = typename Delegate<Ret(Args...)>::Storage;
+    using BatchFunction = void(*)(Storage*, EventBatch<Args...>);
+
+    std::vector<BatchFunction> mBatchFunctions;         // batch stub of each delegate in mDelegates (null if it doesn't accept batches)
+
+    Connection Insert(Delegate<Ret(Args...)> &&delegate, BatchFunction batchFunction = nullptr);
+    void Remove(std::uint32_t index);
+    void Compact();
+    void FreeSlot(std::uint32_t slot);
+
+    template <std::size_t... Indices>
+    static void Emit(Delegate<Ret(Args...)> &delegate, typename EventBatch<Args...>::Event const &event, std::index_sequence<Indices...>) { delegate(std::get<Indices>(event)...); }
+
+    /**** batch stub functions ****/
+    template <typename Type, void(Type::*PtrToBatchMemFun)(EventBatch<Args...>)>
+    static void BatchStub(Storage *data, EventBatch<Args...> events) { ((*reinterpret_cast<Type**>(data))->*PtrToBatchMemFun)(events); }
+
+    template <typename Type>
+    static void BatchStub(Storage *data, EventBatch<Args...> events) { (**reinterpret_cast<Type**>(data))(events); }
+
+    template <typename Type, typename>
+    static void BatchStub(Storage *data, EventBatch<Args...> events) { (*reinterpret_cast<Type*>(data))(events); }
+
+    // stub of a function object accepting batches (stored by pointer if bound as an lvalue, inline otherwise)
+    template <typename Type>
+    static BatchFunction FunctionObjectBatchStub(std::true_type, std::true_type) { return &BatchStub<std::remove_reference_t<Type>>; }
+
+    template <typename Type>
+    static BatchFunction FunctionObjectBatchStub(std::true_type, std::false_type) { return &BatchStub<Type, Type>; }
+
+    template <typename Type, typename IsLvalue>
+    static BatchFunction FunctionObjectBatchStub(std::false_type, IsLvalue) { return nullptr; }
 };
 
+template <typename Ret, typename... Args>
+constexpr std::uint32_t Signal<Ret(Args...)>::NoSlot;
+
 template <typename Ret, typename... Args>
 template <Ret(*FreeFunction)(Args...)>
-void Signal<Ret(Args...)>::Bind()
+Connection Signal<Ret(Args...)>::Bind()
 {
     Delegate<Ret(Args...)> delegate;
     delegate.template Bind<FreeFunction>();
-    mDelegates.push_back(delegate);
+
+    return Insert(std::move(delegate));
 }
 
 template <typename Ret, typename... Args>
 template <typename Type, Ret(Type::*PtrToMemFun)(Args...)>
-void Signal<Ret(Args...)>::Bind(Type &instance)
+Connection Signal<Ret(Args...)>::Bind(Type &instance)
 {
     Delegate<Ret(Args...)> delegate;
     delegate.template Bind<Type, PtrToMemFun>(instance);
-    mDelegates.push_back(delegate);
+
+    return Insert(std::move(delegate));
 }
     
 template <typename Ret, typename... Args>
 template <typename Type, Ret(Type::*PtrToConstMemFun)(Args...) const>
-void Signal<Ret(Args...)>::Bind(Type &instance)
+Connection Signal<Ret(Args...)>::Bind(Type &instance)
 {
     Delegate<Ret(Args...)> delegate;
     delegate.template Bind<Type, PtrToConstMemFun>(instance);
-    mDelegates.push_back(delegate);
+
+    return Insert(std::move(delegate));
 }
     
+template <typename Ret, typename... Args>
+template <typename Type, Ret(Type::*PtrToMemFun)(Args...), void(Type::*PtrToBatchMemFun)(EventBatch<Args...>)>
+Connection Signal<Ret(Args...)>::Bind(Type &instance)
+{
+    Delegate<Ret(Args...)> delegate;
+    delegate.template Bind<Type, PtrToMemFun>(instance);
+
+    return Insert(std::move(delegate), &BatchStub<Type, PtrToBatchMemFun>);
+}
+
 template <typename Ret, typename... Args>
 template <typename Type>
-void Signal<Ret(Args...)>::Bind(Type &&funObj)
+Connection Signal<Ret(Args...)>::Bind(Type &&funObj)
 {
     Delegate<Ret(Args...)> delegate;
     delegate.template Bind(std::forward<Type>(funObj));
-    mDelegates.push_back(delegate);
+
+    return Insert(std::move(delegate), FunctionObjectBatchStub<Type>(IsBatchListener<std::remove_reference_t<Type>, EventBatch<Args...>>(), std::is_lvalue_reference<Type>()));
+}
+
+template <typename Ret, typename... Args>
+bool Signal<Ret(Args...)>::Disconnect(Connection const &connection)
+{
+    if (!Connected(connection))
+        return false;
+
+    Remove(mSlots[connection.mSlot].index);
+
+    return true;
+}
+
+template <typename Ret, typename... Args>
+bool Signal<Ret(Args...)>::Connected(Connection const &connection) const
+{
+    return connection.mSlot < mSlots.size() && mSlots[connection.mSlot].generation == connection.mGeneration;
+}
+
+template <typename Ret, typename... Args>
+void Signal<Ret(Args...)>::Clear()
+{
+    for (std::uint32_t slot : mDelegateSlots)
+        if (slot != NoSlot)
+            FreeSlot(slot);
+
+    mDelegates.clear();
+    mDelegateSlots.clear();
+    mBatchFunctions.clear();
+    mIndex.Clear();
+    mTombstones = 0;
+}
+
+template <typename Ret, typename... Args>
+template <Ret(*FreeFunction)(Args...)>
+bool Signal<Ret(Args...)>::Unbind()
+{
+    Delegate<Ret(Args...)> delegate;
+    delegate.template Bind<FreeFunction>();
+    
+    return Unbind(delegate);
+}
+
+template <typename Ret, typename... Args>
+template <typename Type, Ret(Type::*PtrToMemFun)(Args...)>
+bool Signal<Ret(Args...)>::Unbind(Type &instance)
+{
+    Delegate<Ret(Args...)> delegate;
+    delegate.template Bind<Type, PtrToMemFun>(instance);
+    
+    return Unbind(delegate);
+}
+    
+template <typename Ret, typename... Args>
+template <typename Type, Ret(Type::*PtrToConstMemFun)(Args...) const>
+bool Signal<Ret(Args...)>::Unbind(Type &instance)
+{
+    Delegate<Ret(Args...)> delegate;
+    delegate.template Bind<Type, PtrToConstMemFun>(instance);
+    
+    return Unbind(delegate);
+}
+    
+template <typename Ret, typename... Args>
+template <typename Type, typename>
+bool Signal<Ret(Args...)>::Unbind(Type &funObj)
+{
+    Delegate<Ret(Args...)> delegate;
+    delegate.Bind(funObj);
+    
+    return Unbind(delegate);
+}
+
+template <typename Ret, typename... Args>
+bool Signal<Ret(Args...)>::Unbind(Delegate<Ret(Args...)> const &delegate)
+{
+    std::uint32_t index = mIndex.Find(delegate, mDelegates.data());
+
+    if (index == DelegateIndex<Delegate<Ret(Args...)>>::NoPosition)
+        return false;
+
+    Remove(index);
+
+    return true;
+}
+
+template <typename Ret, typename... Args>
+Connection Signal<Ret(Args...)>::Insert(Delegate<Ret(Args...)> &&delegate, BatchFunction batchFunction)
+{
+    if (!delegate.mManager && mIndex.Find(delegate, mDelegates.data()) != DelegateIndex<Delegate<Ret(Args...)>>::NoPosition)     // already bound
+        return Connection();
+
+    if (mFreeSlot == NoSlot)
+    {
+        mSlots.push_back(Slot{ NoSlot, mSalt });
+        mFreeSlot = std::uint32_t(mSlots.size() - 1);
+    }
+
+    std::uint32_t slot = mFreeSlot;
+
+    mDelegates.push_back(std::move(delegate));
+
+    try
+    {
+        mDelegateSlots.push_back(slot);
+        mBatchFunctions.push_back(batchFunction);
+
+        if (!mDelegates.back().mManager)
+            mIndex.Insert(mDelegates.data(), std::uint32_t(mDelegates.size() - 1));
+    }
+    catch (...)
+    {
+        if (mBatchFunctions.size() == mDelegates.size())
+            mBatchFunctions.pop_back();
+
+        if (mDelegateSlots.size() == mDelegates.size())
+            mDelegateSlots.pop_back();
+
+        mDelegates.pop_back();
+        throw;
+    }
+
+    mFreeSlot = mSlots[slot].index;
+    mSlots[slot].index = std::uint32_t(mDelegates.size() - 1);
+
+    return Connection(slot, mSlots[slot].generation);
+}
+
+template <typename Ret, typename... Args>
+void Signal<Ret(Args...)>::operator()(Args... args)
+{
+    for (std::size_t i = 0; i < mDelegates.size(); i++)
+        if (mDelegateSlots[i] != NoSlot)
+            mDelegates[i](std::forward<Args>(args)...);
+}
+
+template <typename Ret, typename... Args>
+void Signal<Ret(Args...)>::Invoke(Args... args)
+{
+    for (std::size_t i = 0; i < mDelegates.size(); i++)
+        if (mDelegateSlots[i] != NoSlot)
+            mDelegates[i].Invoke(std::forward<Args>(args)...);
+}
+
+template <typename Ret, typename... Args>
+void Signal<Ret(Args...)>::InvokeParallel(ThreadPool &pool, Args... args)
+{
+    pool.ParallelFor(mDelegates.size(), THREAD_POOL_GRAIN, [&](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; i++)
+            if (mDelegateSlots[i] != NoSlot)
+                mDelegates[i](args...);
+    });
+}
+
+template <typename Ret, typename... Args>
+template <typename Combiner>
+Combiner Signal<Ret(Args...)>::Combine(Combiner combiner, Args... args)
+{
+    static_assert(!std::is_void<Ret>::value, "the results of void delegates can't be combined");
+
+    for (std::size_t i = 0; i < mDelegates.size(); i++)
+        if (mDelegateSlots[i] != NoSlot && !combiner(mDelegates[i](args...)))
+            break;
+
+    return combiner;
+}
+
+template <typename Ret, typename... Args>
+void Signal<Ret(Args...)>::EmitBatch(EventBatch<Args...> events)
+{
+    static_assert(std::is_void<Ret>::value, "only void signals can emit batches");
+    static_assert(AreConstEventParameters<Args...>::value, "only signals whose parameters are values or const lvalue references can emit batches");
+
+    for (std::size_t i = 0; i < mDelegates.size(); i++)
+        if (mDelegateSlots[i] == NoSlot)
+            continue;
+        else if (mBatchFunctions[i])
+            mBatchFunctions[i](&mDelegates[i].mData, events);
+        else
+            for (auto const &event : events)
+                Emit(mDelegates[i], event, std::index_sequence_for<Args...>());
+}
+
+// leave a tombstone in place of the delegate at the given position (releasing its function object) and free its slot
+template <typename Ret, typename... Args>
+void Signal<Ret(Args...)>::Remove(std::uint32_t index)
+{
+    std::uint32_t slot = mDelegateSlots[index];
+
+    if (!mDelegates[index].mManager)
+        mIndex.Erase(mDelegates[index], mDelegates.data());
+
+    mDelegates[index].Reset();
+    mDelegateSlots[index] = NoSlot;
+    mBatchFunctions[index] = nullptr;
+    mTombstones++;
+
+    FreeSlot(slot);
+
+    if (2 * mTombstones > mDelegates.size())
+        Compact();
+}
+
+// remove all the tombstones in a single pass (keeping the call order)
+template <typename Ret, typename... Args>
+void Signal<Ret(Args...)>::Compact()
+{
+    std::uint32_t size = 0;
+
+    for (std::uint32_t i = 0; i < mDelegates.size(); i++)
+        if (mDelegateSlots[i] != NoSlot)
+        {
+            if (i != size)
+            {
+                if (!mDelegates[i].mManager)
+                    mIndex.Move(mDelegates[i], mDelegates.data(), size);
+
+                mDelegates[size] = std::move(mDelegates[i]);
+                mDelegateSlots[size] = mDelegateSlots[i];
+                mBatchFunctions[size] = mBatchFunctions[i];
+                mSlots[mDelegateSlots[size]].index = size;
+            }
+
+            size++;
+        }
+
+    mDelegates.erase(mDelegates.begin() + size, mDelegates.end());
+    mDelegateSlots.erase(mDelegateSlots.begin() + size, mDelegateSlots.end());
+    mBatchFunctions.erase(mBatchFunctions.begin() + size, mBatchFunctions.end());
+    mTombstones = 0;
+}
+
+// invalidate the connections to the slot and put it in the free list
+template <typename Ret, typename... Args>
+void Signal<Ret(Args...)>::FreeSlot(std::uint32_t slot)
+{
+    if (++mSlots[slot].generation == 0)     // generation 0 is reserved for null connections
+        mSlots[slot].generation = 1;
+
+    mSlots[slot].index = mFreeSlot;
+    mFreeSlot = slot;
 }
 
 #endif  // SIGNAL_H
\ No newline at end of file
@@ -0,0 +1,20 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <cstdio>
+#include <cstdlib>
+
+/***** test checks *****/
+// unlike assert, checked in release builds too (the tests are built with the benchmarks' flags); variadic so conditions
+// can hold template argument lists
+#define CHECK(...)                                                                                  \
+    do                                                                                              \
+    {                                                                                               \
+        if (!(__VA_ARGS__))                                                                         \
+        {                                                                                           \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #__VA_ARGS__);    \
+            std::exit(1);                                                                           \
+        }                                                                                           \
+    } while (false)
+
+#endif  // CHECK_H
@@ -0,0 +1,133 @@
+#include "signal.hpp"
+#include "check.hpp"
+#include <coroutine>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifndef __cpp_impl_coroutine
+#error "the awaitable signal test needs coroutine support"
+#endif
+
+SIGNAL_ONE_PARAM(IntSignal, int);
+
+// coroutine started eagerly, its frame is destroyed with the task (exceptions are rethrown to the resuming thread)
+class Task
+{
+public:
+    struct promise_type
+    {
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { throw; }
+    };
+
+    Task(Task &&other) noexcept : mCoroutine(other.mCoroutine) { other.mCoroutine = nullptr; }
+    ~Task() { if (mCoroutine) mCoroutine.destroy(); }
+
+    Task &operator=(Task&&) = delete;
+private:
+    explicit Task(std::coroutine_handle<promise_type> coroutine) : mCoroutine(coroutine) {}
+
+    std::coroutine_handle<promise_type> mCoroutine;
+};
+
+using Log = std::vector<std::string>;
+
+Task Listen(IntSignal &signal, Log &log, std::string name, int emissions)
+{
+    for (int i = 0; i < emissions; ++i)
+    {
+        auto [value] = co_await signal;
+        log.push_back(name + std::to_string(value));
+    }
+}
+
+Task Throw(IntSignal &signal)
+{
+    co_await signal.Next();
+    throw std::runtime_error("resumed");
+}
+
+// one emission resumes the coroutines in the order they started awaiting, awaiting again waits for the next emission
+void TestOrder()
+{
+    IntSignal signal;
+    Log log;
+
+    Task a = Listen(signal, log, "a", 2);
+    Task b = Listen(signal, log, "b", 1);
+    Task c = Listen(signal, log, "c", 2);
+
+    signal(1);
+    CHECK(log == Log({ "a1", "b1", "c1" }));
+
+    Task d = Listen(signal, log, "d", 1);
+
+    signal(2);
+    CHECK(log == Log({ "a1", "b1", "c1", "a2", "c2", "d2" }));
+
+    signal(3);
+    CHECK(log.size() == 6);
+}
+
+// destroying an awaiting coroutine unlinks it from the middle or the end of the list
+void TestDestroyAwaiting()
+{
+    IntSignal signal;
+    Log log;
+
+    Task a = Listen(signal, log, "a", 1);
+    {
+        Task b = Listen(signal, log, "b", 1);
+    }
+    Task c = Listen(signal, log, "c", 1);
+    {
+        Task d = Listen(signal, log, "d", 1);
+    }
+    Task e = Listen(signal, log, "e", 1);
+
+    signal(1);
+    CHECK(log == Log({ "a1", "c1", "e1" }));
+}
+
+// when a resumed coroutine throws, the ones not resumed yet are resumed by the next emission before the newer ones
+void TestThrow()
+{
+    IntSignal signal;
+    Log log;
+
+    Task a = Throw(signal);
+    Task b = Listen(signal, log, "b", 1);
+    Task c = Listen(signal, log, "c", 1);
+
+    bool thrown = false;
+
+    try
+    {
+        signal(1);
+    }
+    catch (std::runtime_error const&)
+    {
+        thrown = true;
+    }
+
+    CHECK(thrown);
+    CHECK(log.empty());
+
+    Task d = Listen(signal, log, "d", 1);
+
+    signal(2);
+    CHECK(log == Log({ "b2", "c2", "d2" }));
+}
+
+int main()
+{
+    TestOrder();
+    TestDestroyAwaiting();
+    TestThrow();
+
+    return 0;
+}
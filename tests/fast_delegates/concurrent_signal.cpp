@@ -0,0 +1,117 @@
+#include "concurrent_signal.hpp"
+#include "check.hpp"
+#include <thread>
+#include <vector>
+#include <atomic>
+
+CONCURRENT_SIGNAL_ONE_PARAM(IntSignal, int);
+
+// function object counting its live copies (every snapshot holds a copy of it)
+struct Tracked
+{
+    struct State
+    {
+        std::atomic<int> live{ 0 };
+        IntSignal *signal = nullptr;    // disconnects itself when called if not null
+        Connection connection;
+    };
+
+    explicit Tracked(State &state) : state(&state) { ++state.live; }
+    Tracked(Tracked const &other) noexcept : state(other.state) { ++state->live; }
+    ~Tracked() { --state->live; }
+
+    void operator()(int value) const
+    {
+        CHECK(value == 1);
+
+        if (state->signal)
+            state->signal->Disconnect(state->connection);
+
+        CHECK(state->live > 0);     // the snapshot holding this copy is still alive
+    }
+
+    State *state;
+};
+
+class Counter
+{
+public:
+    void Add(int value) { mCount.fetch_add(value, std::memory_order_relaxed); }
+    int Count() const { return mCount.load(std::memory_order_relaxed); }
+private:
+    std::atomic<int> mCount{ 0 };
+};
+
+// emitters never see a torn delegate set while a writer binds and disconnects, retired snapshots are reclaimed
+void TestConcurrentWrites()
+{
+    IntSignal signal;
+    Counter permanent, transient;
+    Tracked::State tracked;
+
+    signal.Bind<Counter, &Counter::Add>(permanent);
+    signal.Bind(Tracked(tracked));
+
+    std::atomic<bool> stop{ false };
+    std::atomic<int> emissions{ 0 };
+    std::vector<std::thread> emitters;
+
+    for (int i = 0; i < 3; ++i)
+        emitters.emplace_back([&]()
+        {
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                signal(1);
+                emissions.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+
+    for (int i = 0; i < 2000; ++i)
+    {
+        Tracked::State churned;
+        Connection connection = signal.Bind(Tracked(churned));
+        CHECK(connection);
+        CHECK(signal.Bind<Counter, &Counter::Add>(transient));
+        CHECK(signal.Disconnect(connection));
+        CHECK(signal.Unbind<Counter, &Counter::Add>(transient));
+        CHECK(!signal.Connected(connection));
+
+        while (churned.live != 0)   // copies in snapshots still being read are deleted by the emitters
+            std::this_thread::yield();
+    }
+
+    stop = true;
+
+    for (auto &emitter : emitters)
+        emitter.join();
+
+    CHECK(permanent.Count() == emissions);  // the permanent listener is in every snapshot
+
+    signal(1);      // nobody else reads, the emission deletes every retired snapshot
+
+    CHECK(tracked.live == 2);   // the copy in the signal and the one in the current snapshot
+}
+
+// a snapshot isn't deleted while the emission reading it runs, the emission deletes it when it's done
+void TestReclaimOnEmissionExit()
+{
+    IntSignal signal;
+    Tracked::State state;
+
+    state.signal = &signal;
+    state.connection = signal.Bind(Tracked(state));
+    CHECK(state.live == 2);
+
+    signal(1);      // disconnects the listener while reading the snapshot holding it
+
+    CHECK(state.live == 0);
+    CHECK(!signal);
+}
+
+int main()
+{
+    TestConcurrentWrites();
+    TestReclaimOnEmissionExit();
+
+    return 0;
+}
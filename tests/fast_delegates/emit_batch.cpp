@@ -0,0 +1,120 @@
+#include "signal.hpp"
+#include "check.hpp"
+#include <string>
+#include <vector>
+
+using Event = EventBatch<int, std::string const&>::Event;
+using Events = std::vector<Event>;
+
+class Listener
+{
+public:
+    void Receive(int value, std::string const &name) { mEvents.emplace_back(value, name); }
+    void ReceiveBatch(EventBatch<int, std::string const&> events) { mBatches++; mEvents.insert(mEvents.end(), events.begin(), events.end()); }
+
+    Events mEvents;
+    int mBatches = 0;
+};
+
+// function object with an overload taking whole batches
+struct BatchCounter
+{
+    void operator()(int, std::string const&) const { counts->single++; }
+    void operator()(EventBatch<int, std::string const&> events) const { counts->batches++; counts->events += int(events.Size()); }
+
+    struct Counts
+    {
+        int single = 0;
+        int batches = 0;
+        int events = 0;
+    } *counts;
+};
+
+Events const events{ Event(1, "a"), Event(2, "b"), Event(3, "c") };
+
+// batch listeners get one call per batch, the other listeners one call per event, in binding order
+void TestListeners()
+{
+    Signal<void(int, std::string const&)> signal;
+    Listener batched, plain;
+    Events lambdaEvents;
+    int genericCalls = 0;
+    BatchCounter::Counts lvalueCounts, rvalueCounts;
+    BatchCounter lvalueCounter{ &lvalueCounts };
+
+    CHECK(signal.Bind<Listener, &Listener::Receive, &Listener::ReceiveBatch>(batched));
+    CHECK(signal.Bind<Listener, &Listener::Receive>(plain));
+    CHECK(signal.Bind([&lambdaEvents](int value, std::string const &name) { lambdaEvents.emplace_back(value, name); }));
+    CHECK(signal.Bind([&genericCalls](auto&&...) { genericCalls++; }));   // not detected as a batch listener
+    CHECK(signal.Bind(lvalueCounter));
+    CHECK(signal.Bind(BatchCounter{ &rvalueCounts }));
+
+    signal.EmitBatch(events);
+
+    CHECK(batched.mBatches == 1 && batched.mEvents == events);
+    CHECK(plain.mBatches == 0 && plain.mEvents == events);
+    CHECK(lambdaEvents == events);
+    CHECK(genericCalls == 3);
+    CHECK(lvalueCounts.batches == 1 && lvalueCounts.events == 3 && lvalueCounts.single == 0);
+    CHECK(rvalueCounts.batches == 1 && rvalueCounts.events == 3 && rvalueCounts.single == 0);
+
+    // plain emission calls the per event functions of the batch listeners too
+    signal(4, "d");
+    CHECK(batched.mBatches == 1 && batched.mEvents.size() == 4);
+    CHECK(lvalueCounts.single == 1 && rvalueCounts.single == 1);
+
+    // arrays and partial batches
+    Event array[] = { Event(5, "e") };
+    signal.EmitBatch(array);
+    signal.EmitBatch(EventBatch<int, std::string const&>(events.data(), 1));
+    CHECK(batched.mBatches == 3 && batched.mEvents.size() == 6);
+    CHECK(plain.mEvents.size() == 6 && plain.mEvents.back() == events.front());
+}
+
+// the batch functions follow their delegates when disconnected delegates are compacted away
+void TestCompaction()
+{
+    Signal<void(int, std::string const&)> signal;
+    std::vector<Listener> listeners(8);
+    std::vector<Connection> connections;
+
+    for (std::size_t i = 0; i < listeners.size(); i++)
+        if (i % 2 == 0)
+            connections.push_back(signal.Bind<Listener, &Listener::Receive, &Listener::ReceiveBatch>(listeners[i]));
+        else
+            connections.push_back(signal.Bind<Listener, &Listener::Receive>(listeners[i]));
+
+    for (std::size_t i = 0; i < 5; i++)
+        CHECK(signal.Disconnect(connections[i]));
+
+    signal.EmitBatch(events);
+
+    for (std::size_t i = 0; i < listeners.size(); i++)
+    {
+        CHECK(listeners[i].mBatches == (i >= 5 && i % 2 == 0 ? 1 : 0));
+        CHECK(listeners[i].mEvents == (i >= 5 ? events : Events()));
+    }
+}
+
+// signals taking values emit batches too
+void TestValueParameters()
+{
+    Signal<void(int, double)> signal;
+    double sum = 0;
+
+    std::tuple<int, double> const values[] = { std::make_tuple(1, 0.5), std::make_tuple(2, 0.25) };
+
+    signal.Bind([&sum](int i, double d) { sum += i * d; });
+    signal.EmitBatch(values);
+
+    CHECK(sum == 1.0);
+}
+
+int main()
+{
+    TestListeners();
+    TestCompaction();
+    TestValueParameters();
+
+    return 0;
+}
@@ -0,0 +1,12 @@
+#include "signal.hpp"
+
+// mustn't compile: the events of a batch are shared by the listeners, they can't be passed as non-const references
+int main()
+{
+    Signal<void(int&)> signal;
+    std::tuple<int> const events[] = { std::make_tuple(1) };
+
+    signal.EmitBatch(events);
+
+    return 0;
+}
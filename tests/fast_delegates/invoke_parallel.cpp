@@ -0,0 +1,121 @@
+#include "signal.hpp"
+#include "check.hpp"
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+SIGNAL_ONE_PARAM(IntSignal, int);
+
+std::atomic<int> freeCalls{ 0 };
+
+void Free(int value)
+{
+    CHECK(value == 7);
+    freeCalls++;
+}
+
+class Listener
+{
+public:
+    void Receive(int value) { CHECK(value == 7); mCalls++; }
+    void Throw(int) { mCalls++; throw std::runtime_error("listener"); }
+
+    int Calls() const { return mCalls; }
+private:
+    std::atomic<int> mCalls{ 0 };
+};
+
+// every bound listener runs exactly once, the disconnected ones (tombstones) don't run
+void TestExactlyOnce(ThreadPool &pool)
+{
+    std::vector<Listener> listeners(3000);
+    std::vector<Connection> connections;
+    IntSignal signal;
+
+    for (auto &listener : listeners)
+        connections.push_back(signal.Bind<Listener, &Listener::Receive>(listener));
+
+    CHECK(signal.Bind<&Free>());
+
+    for (std::size_t i = 0; i < listeners.size(); i += 7)
+        CHECK(signal.Disconnect(connections[i]));
+
+    freeCalls = 0;
+    signal.InvokeParallel(pool, 7);
+
+    for (std::size_t i = 0; i < listeners.size(); i++)
+        CHECK(listeners[i].Calls() == (i % 7 == 0 ? 0 : 1));
+
+    CHECK(freeCalls == 1);
+}
+
+// listeners emitting in parallel themselves share the pool with the outer emission
+void TestNested(ThreadPool &pool)
+{
+    std::vector<Listener> inner(500), outer(100);
+    IntSignal innerSignal, outerSignal;
+
+    for (auto &listener : inner)
+        innerSignal.Bind<Listener, &Listener::Receive>(listener);
+
+    for (auto &listener : outer)
+        outerSignal.Bind<Listener, &Listener::Receive>(listener);
+
+    struct Nested
+    {
+        IntSignal *signal;
+        ThreadPool *pool;
+    } nested{ &innerSignal, &pool };
+
+    outerSignal.Bind([&nested](int value) { nested.signal->InvokeParallel(*nested.pool, value); });
+    outerSignal.InvokeParallel(pool, 7);
+
+    for (auto &listener : outer)
+        CHECK(listener.Calls() == 1);
+
+    for (auto &listener : inner)
+        CHECK(listener.Calls() == 1);
+}
+
+// a throwing listener's exception reaches the caller once the other listeners have returned
+void TestThrow(ThreadPool &pool)
+{
+    std::vector<Listener> listeners(1000);
+    IntSignal signal;
+
+    for (auto &listener : listeners)
+        signal.Bind<Listener, &Listener::Receive>(listener);
+
+    Listener thrower;
+    signal.Bind<Listener, &Listener::Throw>(thrower);
+
+    bool thrown = false;
+
+    try
+    {
+        signal.InvokeParallel(pool, 7);
+    }
+    catch (std::runtime_error const&)
+    {
+        thrown = true;
+    }
+
+    CHECK(thrown);
+    CHECK(thrower.Calls() == 1);
+
+    for (auto &listener : listeners)
+        CHECK(listener.Calls() <= 1);
+}
+
+int main()
+{
+    ThreadPool pool(3), serial(0);
+
+    TestExactlyOnce(pool);
+    TestExactlyOnce(serial);
+    TestExactlyOnce(ThreadPool::Instance());
+    TestNested(pool);
+    TestThrow(pool);
+
+    return 0;
+}
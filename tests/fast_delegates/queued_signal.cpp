@@ -0,0 +1,153 @@
+#include "queued_signal.hpp"
+#include "check.hpp"
+#include <thread>
+#include <vector>
+
+QUEUED_SIGNAL_ONE_PARAM(IntSignal, int);
+
+class Recorder
+{
+public:
+    void Record(int value) { mValues.push_back(value); }
+    std::vector<int> const &Values() const { return mValues; }
+private:
+    std::vector<int> mValues;
+};
+
+// listener posting more events to the signal it's called by
+class Reposter
+{
+public:
+    Reposter(IntSignal &signal, int trigger, std::vector<int> events) : mSignal(signal), mTrigger(trigger), mEvents(std::move(events)) {}
+
+    void Receive(int value)
+    {
+        if (value == mTrigger)
+            for (int event : mEvents)
+                CHECK(mSignal.Post(event));
+    }
+private:
+    IntSignal &mSignal;
+    int mTrigger;
+    std::vector<int> mEvents;
+};
+
+// events are emitted in posting order, the ones posted while flushing by the next flush
+void TestOrder()
+{
+    IntSignal signal(4);
+    Recorder recorder;
+    Reposter reposter(signal, 2, { 10, 11 });
+
+    signal.Bind<Recorder, &Recorder::Record>(recorder);
+    signal.Bind<Reposter, &Reposter::Receive>(reposter);
+
+    for (int i = 0; i < 3; ++i)
+        CHECK(signal.Post(i));
+
+    signal.Flush();
+    CHECK(recorder.Values() == std::vector<int>({ 0, 1, 2 }));
+    CHECK(signal.Size() == 2);
+
+    signal.Flush();
+    CHECK(recorder.Values() == std::vector<int>({ 0, 1, 2, 10, 11 }));
+    CHECK(signal.Size() == 0);
+}
+
+void TestGrow()
+{
+    IntSignal signal(3, QueueOverflowPolicy::Grow);
+    Recorder recorder;
+
+    signal.Bind<Recorder, &Recorder::Record>(recorder);
+    CHECK(signal.Capacity() == 4);
+
+    // wrap around the ring buffer before growing
+    CHECK(signal.Post(-2));
+    CHECK(signal.Post(-1));
+    signal.Flush();
+
+    for (int i = 0; i < 9; ++i)
+        CHECK(signal.Post(i));
+
+    CHECK(signal.Size() == 9);
+    CHECK(signal.Capacity() == 16);
+
+    signal.Flush();
+    CHECK(recorder.Values() == std::vector<int>({ -2, -1, 0, 1, 2, 3, 4, 5, 6, 7, 8 }));
+}
+
+void TestDrop()
+{
+    IntSignal signal(2, QueueOverflowPolicy::Drop);
+    Recorder recorder;
+
+    signal.Bind<Recorder, &Recorder::Record>(recorder);
+
+    CHECK(signal.Post(0));
+    CHECK(signal.Post(1));
+    CHECK(!signal.Post(2));
+    CHECK(signal.Capacity() == 2);
+
+    signal.Flush();
+    CHECK(signal.Post(3));
+    signal.Flush();
+    CHECK(recorder.Values() == std::vector<int>({ 0, 1, 3 }));
+}
+
+// a producer posting to a full queue waits for the flushing thread
+void TestBlock()
+{
+    IntSignal signal(2, QueueOverflowPolicy::Block);
+    Recorder recorder;
+    int const count = 1000;
+
+    signal.Bind<Recorder, &Recorder::Record>(recorder);
+
+    std::thread producer([&]()
+    {
+        for (int i = 0; i < count; ++i)
+            CHECK(signal.Post(i));
+    });
+
+    while (recorder.Values().size() != count)
+        signal.Flush();
+
+    producer.join();
+
+    CHECK(signal.Capacity() == 2);
+
+    for (int i = 0; i < count; ++i)
+        CHECK(recorder.Values()[i] == i);
+}
+
+// a listener posting to the full queue its thread is flushing grows the queue instead of waiting forever
+void TestBlockFromListener()
+{
+    IntSignal signal(2, QueueOverflowPolicy::Block);
+    Recorder recorder;
+    Reposter reposter(signal, 0, { 10, 11, 12 });
+
+    signal.Bind<Recorder, &Recorder::Record>(recorder);
+    signal.Bind<Reposter, &Reposter::Receive>(reposter);
+
+    CHECK(signal.Post(0));
+    CHECK(signal.Post(1));
+
+    signal.Flush();
+    CHECK(signal.Capacity() == 4);
+
+    signal.Flush();
+    CHECK(recorder.Values() == std::vector<int>({ 0, 1, 10, 11, 12 }));
+}
+
+int main()
+{
+    TestOrder();
+    TestGrow();
+    TestDrop();
+    TestBlock();
+    TestBlockFromListener();
+
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include "delegate.hpp"
+#include "check.hpp"
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+std::atomic<int> freeCalls{ 0 };
+
+void Free(int value)
+{
+    CHECK(value == 7);
+    freeCalls++;
+}
+
+class Listener
+{
+public:
+    void Receive(int value) { CHECK(value == 7); mCalls++; }
+    void Batched(int value) { CHECK(value == 7); mCalls++; }
+    void Throw(int) { mCalls++; throw std::runtime_error("listener"); }
+
+    int Calls() const { return mCalls; }
+private:
+    std::atomic<int> mCalls{ 0 };
+};
+
+// every listener (plain, batched, free) runs exactly once, also after unbinding some and on a pool without workers
+template <typename MulticastType>
+void TestExactlyOnce(ThreadPool &pool)
+{
+    std::vector<Listener> listeners(3000);
+    MulticastType multicast;
+
+    for (std::size_t i = 0; i < listeners.size(); i++)
+        if (i % 3 == 0)
+            CHECK(multicast.template BindBatched<&Listener::Batched>(listeners[i]));
+        else if (i % 3 == 1)
+            CHECK(multicast.template BindBatched<&Listener::Receive>(listeners[i]));
+        else
+            CHECK(multicast.template Bind<&Listener::Receive>(listeners[i]));
+
+    CHECK(multicast.template Bind<&Free>());
+
+    for (std::size_t i = 0; i < listeners.size(); i += 7)
+        CHECK(multicast.template Unbind<&Listener::Receive>(listeners[i]) || multicast.template Unbind<&Listener::Batched>(listeners[i]));
+
+    freeCalls = 0;
+    multicast.InvokeParallel(pool, 7);
+
+    for (std::size_t i = 0; i < listeners.size(); i++)
+        CHECK(listeners[i].Calls() == (i % 7 == 0 ? 0 : 1));
+
+    CHECK(freeCalls == 1);
+}
+
+// listeners emitting in parallel themselves share the pool with the outer emission
+template <typename MulticastType>
+void TestNested(ThreadPool &pool)
+{
+    std::vector<Listener> inner(500);
+    MulticastType innerMulticast;
+
+    for (auto &listener : inner)
+        innerMulticast.template Bind<&Listener::Receive>(listener);
+
+    std::vector<Listener> outer(100);
+    MulticastType outerMulticast;
+
+    for (auto &listener : outer)
+        outerMulticast.template Bind<&Listener::Receive>(listener);
+
+    outerMulticast.Bind([&innerMulticast, &pool](int value) { innerMulticast.InvokeParallel(pool, value); });
+    outerMulticast.InvokeParallel(pool, 7);
+
+    for (auto &listener : outer)
+        CHECK(listener.Calls() == 1);
+
+    for (auto &listener : inner)
+        CHECK(listener.Calls() == 1);
+}
+
+// a throwing listener's exception reaches the caller once the other listeners have returned
+template <typename MulticastType>
+void TestThrow(ThreadPool &pool)
+{
+    std::vector<Listener> listeners(1000);
+    MulticastType multicast;
+
+    for (auto &listener : listeners)
+        multicast.template Bind<&Listener::Receive>(listener);
+
+    Listener thrower;
+    multicast.template Bind<&Listener::Throw>(thrower);
+
+    bool thrown = false;
+
+    try
+    {
+        multicast.InvokeParallel(pool, 7);
+    }
+    catch (std::runtime_error const&)
+    {
+        thrown = true;
+    }
+
+    CHECK(thrown);
+    CHECK(thrower.Calls() == 1);
+
+    for (auto &listener : listeners)
+        CHECK(listener.Calls() <= 1);
+}
+
+template <typename MulticastType>
+void TestInvokeParallel()
+{
+    ThreadPool pool(3), serial(0);
+
+    TestExactlyOnce<MulticastType>(pool);
+    TestExactlyOnce<MulticastType>(serial);
+    TestExactlyOnce<MulticastType>(ThreadPool::Instance());
+    TestNested<MulticastType>(pool);
+    TestThrow<MulticastType>(pool);
+}
+
+int main()
+{
+    TestInvokeParallel<MulticastDelegate<void(int)>>();
+    TestInvokeParallel<PackedMulticastDelegate<void(int)>>();
+
+    return 0;
+}
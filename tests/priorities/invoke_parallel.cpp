@@ -0,0 +1,77 @@
+#include "signal.hpp"
+#include "check.hpp"
+#include <atomic>
+#include <vector>
+
+// also built for the payload variant (its Bind takes the same arguments when no payload is given)
+SIGNAL_ONE_PARAM(IntSignal, int);
+
+constexpr unsigned int Levels = 5;
+constexpr int PerLevel = 300;      // several parallel tasks per level
+
+std::atomic<int> done[Levels];      // listeners of each level that returned
+
+class Listener
+{
+public:
+    // the levels of higher priority have all returned, the lower ones haven't started
+    void Receive(int value)
+    {
+        CHECK(value == 7);
+
+        for (unsigned int level = 0; level < Levels; level++)
+            if (level > mLevel)
+                CHECK(done[level] == PerLevel);
+            else if (level < mLevel)
+                CHECK(done[level] == 0);
+
+        mCalls++;
+        done[mLevel]++;
+    }
+
+    unsigned int mLevel = 0;
+    std::atomic<int> mCalls{ 0 };
+};
+
+void TestPriorityOrder(ThreadPool &pool)
+{
+    std::vector<Listener> listeners(Levels * PerLevel);
+    std::vector<Connection> connections;
+    IntSignal signal;
+
+    // bind with interleaved priorities, then move a few listeners to another level
+    for (std::size_t i = 0; i < listeners.size(); i++)
+    {
+        listeners[i].mLevel = unsigned(i % Levels);
+        connections.push_back(signal.Bind(listeners[i], &Listener::Receive, listeners[i].mLevel));
+    }
+
+    for (std::size_t i = 0; i < 2 * Levels; i += 2)
+    {
+        std::size_t other = i + 1;
+
+        listeners[i].mLevel = listeners[other].mLevel;
+        connections[i].SetPriority(listeners[i].mLevel);
+        listeners[other].mLevel = unsigned(i % Levels);
+        connections[other].SetPriority(listeners[other].mLevel);
+    }
+
+    for (auto &count : done)
+        count = 0;
+
+    signal.InvokeParallel(pool, 7);
+
+    for (auto &listener : listeners)
+        CHECK(listener.mCalls == 1);
+}
+
+int main()
+{
+    ThreadPool pool(3), serial(0);
+
+    TestPriorityOrder(pool);
+    TestPriorityOrder(serial);
+    TestPriorityOrder(ThreadPool::Instance());
+
+    return 0;
+}